@@ -0,0 +1,122 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include "utils.h"
+#include "evaluate_mltl.h"
+#include "evaluate_dp.h"
+#include "evaluate_bits.h"
+#include "evaluate_rle.h"
+#include "work_pool.h"
+
+using namespace std;
+
+/*
+ * Times the evaluation engines on a random trace for growing interval widths.
+ * Usage: benchmark [trace length]
+ * The recursive and memoized evaluators are only timed while their work stays
+ * small, since it grows with the product of nested interval widths.
+ */
+
+/*
+ * Random trace over n variables, except that p0 is only true once every
+ * period steps, so F[0,period] p0 has to scan most of its window.
+ */
+static vector<string> random_trace(int length, int n, int period, unsigned seed) {
+    mt19937 gen(seed);
+    vector<string> trace(length, string(n, '0'));
+    for (int t = 0; t < length; ++t) {
+        for (int p = 1; p < n; ++p) {
+            trace[t][p] = (gen() & 1) ? '1' : '0';
+        }
+        trace[t][0] = (t % period == period - 1) ? '1' : '0';
+    }
+    return trace;
+}
+
+template <typename F>
+static double time_ms(F f) {
+    auto start = chrono::steady_clock::now();
+    f();
+    auto end = chrono::steady_clock::now();
+    return chrono::duration<double, milli>(end - start).count();
+}
+
+int main(int argc, char** argv) {
+    int length = (argc > 1) ? stoi(argv[1]) : 200000;
+    vector<int> widths = {10, 100, 1000, 10000, 65535};
+    const long recursive_budget = 10000000; // inner steps
+    const long memo_budget = 100000000;
+
+    cout << "trace length: " << length << endl;
+    cout << "avx2: " << (avx2_enabled() ? "yes" : "no") << endl;
+    const int threads = hardware_threads();
+    cout << "threads: " << threads << endl;
+    // shaped like the rv14 / nasa-atc specs: a wide G over nested windows,
+    // with and without a binary temporal operator
+    vector<string> shapes = {"G[0,ub](F[0,ub]p0&(p1R[0,ub]!p0))",
+                             "G[0,ub](F[0,ub]p0|(p1&!p2))"};
+    for (const string& shape : shapes) {
+        cout << endl << shape << endl;
+        cout << "ub\trecursive (ms)\tmemo (ms)\tdp (ms)\tdp -j (ms)\tbits (ms)\trle (ms)\tverdict" << endl;
+        for (int ub : widths) {
+            string formula = shape;
+            for (size_t pos; (pos = formula.find("ub")) != string::npos; ) {
+                formula.replace(pos, 2, to_string(ub));
+            }
+            CompiledFormula compiled = compile_mltl(formula);
+            vector<string> trace = random_trace(length, 3, ub, 42);
+
+            bool dp_verdict = false;
+            double dp_ms = time_ms([&]() { dp_verdict = evaluate_dp(compiled, trace); });
+
+            bool parallel_verdict = false;
+            double parallel_ms = time_ms([&]() { parallel_verdict = evaluate_dp_parallel(compiled, trace, threads); });
+            if (parallel_verdict != dp_verdict) {
+                cout << "verdict mismatch for " << formula << endl;
+                return 1;
+            }
+
+            PackedTrace packed = pack_trace(trace);
+            bool bits_verdict = false;
+            double bits_ms = time_ms([&]() { bits_verdict = evaluate_bits(compiled, packed); });
+            if (bits_verdict != dp_verdict) {
+                cout << "verdict mismatch for " << formula << endl;
+                return 1;
+            }
+
+            RLETrace rle = encode_rle(trace);
+            bool rle_verdict = false;
+            double rle_ms = time_ms([&]() { rle_verdict = evaluate_rle(compiled, rle); });
+            if (rle_verdict != dp_verdict) {
+                cout << "verdict mismatch for " << formula << endl;
+                return 1;
+            }
+
+            string recursive_ms = "-";
+            if ((long)ub * ub <= recursive_budget) {
+                bool verdict = false;
+                recursive_ms = to_string(time_ms([&]() { verdict = evaluate(compiled, trace); }));
+                if (verdict != dp_verdict) {
+                    cout << "verdict mismatch for " << formula << endl;
+                    return 1;
+                }
+            }
+            // memoization stops repeated (node, suffix) work, but every F/G
+            // still scans its own window, so it gets a larger budget only
+            string memo_ms = "-";
+            if ((long)ub * ub <= memo_budget) {
+                bool verdict = false;
+                memo_ms = to_string(time_ms([&]() { verdict = evaluate_memo(compiled, trace); }));
+                if (verdict != dp_verdict) {
+                    cout << "verdict mismatch for " << formula << endl;
+                    return 1;
+                }
+            }
+            cout << ub << "\t" << recursive_ms << "\t" << memo_ms << "\t" << dp_ms << "\t" << parallel_ms << "\t" << bits_ms << "\t" << rle_ms
+                 << "\t" << dp_verdict << endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "codegen.h"
+
+using namespace std;
+
+/*
+ * Positions [lo, hi] at which a node's value can be read while evaluating
+ * the root at position 0, before clipping to the trace length
+ */
+struct Demand {
+    long lo = 0;
+    long hi = 0;
+};
+
+/*
+ * Demanded positions of every node, top-down from the root. Temporal
+ * operators shift their operands' positions by their interval, and a node
+ * shared by several parents (see simplify()) covers what all of them read.
+ */
+static vector<Demand> demands(const CompiledFormula& CF) {
+    vector<Demand> D(CF.nodes.size());
+    vector<char> reached(CF.nodes.size(), 0);
+    reached[CF.root] = 1;
+    for (int i = CF.root; i >= 0; --i) {
+        const MLTLNode& n = CF.nodes[i];
+        Demand d = D[i];
+        if (is_temporal(n.op)) {
+            d.lo += n.lb;
+            d.hi += n.ub;
+        }
+        for (int operand : {n.left, n.right}) {
+            if (operand == -1) {
+                continue;
+            }
+            if (!reached[operand]) {
+                D[operand] = d;
+                reached[operand] = 1;
+            } else {
+                D[operand].lo = min(D[operand].lo, d.lo);
+                D[operand].hi = max(D[operand].hi, d.hi);
+            }
+        }
+    }
+    return D;
+}
+
+/*
+ * C++ expression for the value of node i at position s. Only temporal
+ * nodes are stored, everything else is expanded inline.
+ */
+static string expression(const CompiledFormula& CF, const vector<Demand>& D, int i, const string& s) {
+    const MLTLNode& n = CF.nodes[i];
+    switch (n.op) {
+    case MLTLOp::TRUE_CONS:
+        return "true";
+    case MLTLOp::FALSE_CONS:
+        return "false";
+    case MLTLOp::PROP_VAR:
+        // the empty suffix at position N satisfies no variable
+        return "(" + s + " < N && rows[(" + s + ") * width + " + to_string(n.var) + "] != '0')";
+    case MLTLOp::NOT:
+        return "!" + expression(CF, D, n.left, s);
+    case MLTLOp::AND:
+        return "(" + expression(CF, D, n.left, s) + " && " + expression(CF, D, n.right, s) + ")";
+    case MLTLOp::OR:
+        return "(" + expression(CF, D, n.left, s) + " || " + expression(CF, D, n.right, s) + ")";
+    case MLTLOp::IMPLIES:
+        return "(!" + expression(CF, D, n.left, s) + " || " + expression(CF, D, n.right, s) + ")";
+    default:
+        return "v" + to_string(i) + "[" + s + " - " + to_string(D[i].lo) + "]";
+    }
+}
+
+/*
+ * Emits the loop filling next index array x<i><side> for positions
+ * [lo, min(hi, N)] of operand, see next_index() in evaluate_dp.cpp.
+ * Positions past the demanded ones are never inside a window, so the
+ * array ends in N + 1 like an operand that never takes the value.
+ */
+static void emit_next_index(string& out, const CompiledFormula& CF, const vector<Demand>& D, int i,
+                            const string& side, int operand, bool value, long lo, long hi) {
+    string x = "x" + to_string(i) + side;
+    string e = expression(CF, D, operand, "s");
+    out += "    static thread_local std::vector<long> " + x + "(" + to_string(hi - lo + 1) + ");\n";
+    out += "    for (long s = std::min(" + to_string(hi) + "L, N); s >= " + to_string(lo) + "; --s) {\n";
+    out += "        " + x + "[s - " + to_string(lo) + "] = " + (value ? "" : "!") + e + " ? s : (s < std::min(" +
+           to_string(hi) + "L, N) ? " + x + "[s + 1 - " + to_string(lo) + "] : N + 1);\n";
+    out += "    }\n";
+}
+
+/*
+ * Emits the code computing the stored values of temporal node i,
+ * the same kernels as compute_truth_vector() in evaluate_dp.cpp
+ */
+static void emit_temporal(string& out, const CompiledFormula& CF, const vector<Demand>& D, int i) {
+    const MLTLNode& n = CF.nodes[i];
+    const long lo = D[i].lo, hi = D[i].hi;
+    const string a = to_string(n.lb), b = to_string(n.ub);
+    const string v = "v" + to_string(i), x = "x" + to_string(i);
+    // index of position t in the operands' next index arrays
+    const string at = "[t - " + to_string(lo) + "]";
+
+    out += "    // " + formula_to_string(CF, i) + "\n";
+    out += "    static thread_local std::vector<char> " + v + "(" + to_string(hi - lo + 1) + ");\n";
+    switch (n.op) {
+    case MLTLOp::FINALLY:
+        emit_next_index(out, CF, D, i, "l", n.left, true, lo + n.lb, hi + n.ub);
+        out += "    for (long t = " + to_string(lo) + "; t <= std::min(" + to_string(hi) + "L, N); ++t) {\n";
+        out += "        " + v + "[t - " + to_string(lo) + "] = t + " + a + " < N && " + x + "l" + at +
+               " <= std::min(t + " + b + ", N - 1);\n";
+        break;
+    case MLTLOp::GLOBALLY:
+        emit_next_index(out, CF, D, i, "l", n.left, false, lo + n.lb, hi + n.ub);
+        out += "    for (long t = " + to_string(lo) + "; t <= std::min(" + to_string(hi) + "L, N); ++t) {\n";
+        out += "        " + v + "[t - " + to_string(lo) + "] = t + " + a + " >= N || " + x + "l" + at +
+               " > std::min(t + " + b + ", N);\n";
+        break;
+    case MLTLOp::UNTIL:
+        emit_next_index(out, CF, D, i, "r", n.right, true, lo + n.lb, hi + n.ub);
+        emit_next_index(out, CF, D, i, "l", n.left, false, lo + n.lb, hi + n.ub);
+        out += "    for (long t = " + to_string(lo) + "; t <= std::min(" + to_string(hi) + "L, N); ++t) {\n";
+        out += "        " + v + "[t - " + to_string(lo) + "] = t + " + a + " < N && " + x + "r" + at +
+               " <= std::min(t + " + b + ", N - 1) && " + x + "l" + at + " >= " + x + "r" + at + ";\n";
+        break;
+    case MLTLOp::RELEASE:
+        emit_next_index(out, CF, D, i, "r", n.right, false, lo + n.lb, hi + n.ub);
+        emit_next_index(out, CF, D, i, "l", n.left, true, lo + n.lb, hi + n.ub);
+        out += "    for (long t = " + to_string(lo) + "; t <= std::min(" + to_string(hi) + "L, N); ++t) {\n";
+        out += "        " + v + "[t - " + to_string(lo) + "] = t + " + a + " >= N || " + x + "r" + at +
+               " > std::min(t + " + b + ", N - 1) || " + x + "l" + at + " < " + x + "r" + at + ";\n";
+        break;
+    default:
+        break;
+    }
+    out += "    }\n";
+}
+
+/*
+ * Standalone program around mltl_evaluate: one trace per line of the given
+ * file or of stdin, "line : verdict" per trace on stdout
+ */
+static const char* standalone_main = R"(
+#ifdef MLTL_CODEGEN_MAIN
+#include <fstream>
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv) {
+    std::ifstream file;
+    if (argc > 1) {
+        file.open(argv[1]);
+        if (!file) {
+            std::cerr << "Could not open " << argv[1] << "." << std::endl;
+            return 1;
+        }
+    }
+    std::istream& in = (argc > 1) ? file : std::cin;
+    std::string line, rows;
+    for (long i = 0; std::getline(in, line); ++i) {
+        rows.clear();
+        long width = -1, length = 0, column = 0;
+        for (char c : line) {
+            if (c == ',') {
+                if (width == -1) {
+                    width = column;
+                }
+                if (column != width) {
+                    std::cerr << "Trace " << i << " has timesteps of different widths." << std::endl;
+                    return 1;
+                }
+                ++length;
+                column = 0;
+            } else if (c != ' ' && c != '\r') {
+                rows += c;
+                ++column;
+            }
+        }
+        if (column > 0) {
+            if (width != -1 && column != width) {
+                std::cerr << "Trace " << i << " has timesteps of different widths." << std::endl;
+                return 1;
+            }
+            width = column;
+            ++length;
+        }
+        int verdict = mltl_evaluate(rows.data(), length, std::max(width, 0L));
+        if (verdict < 0) {
+            std::cerr << "Trace " << i << " is narrower than the formula's variables." << std::endl;
+            return 1;
+        }
+        std::cout << i << " : " << verdict << "\n";
+    }
+    return 0;
+}
+#endif
+)";
+
+string generate_evaluator(const CompiledFormula& CF) {
+    vector<Demand> D = demands(CF);
+    int max_var = -1;
+    for (const MLTLNode& n : CF.nodes) {
+        if (n.op == MLTLOp::PROP_VAR) {
+            max_var = max(max_var, n.var);
+        }
+    }
+
+    string out;
+    out += "// Generated by mltl_codegen, do not edit.\n";
+    out += "// " + formula_to_string(CF) + "\n";
+    out += "#include <algorithm>\n#include <vector>\n\n";
+    out += "extern \"C\" const char* const mltl_formula = \"" + formula_to_string(CF) + "\";\n\n";
+    out += "extern \"C\" int mltl_evaluate(const char* rows, long N, long width) {\n";
+    out += "    if (N > 0 && width <= " + to_string(max_var) + ") {\n";
+    out += "        return -1;\n";
+    out += "    }\n";
+    // operands precede their parents, so post-order is evaluation order
+    for (int i = 0; i < CF.nodes.size(); ++i) {
+        if (is_temporal(CF.nodes[i].op)) {
+            emit_temporal(out, CF, D, i);
+        }
+    }
+    out += "    return " + expression(CF, D, CF.root, "0") + ";\n";
+    out += "}\n";
+    out += standalone_main;
+    return out;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <string>
+#include "compile_mltl.h"
+
+using namespace std;
+
+/*
+ * Input: compiled MLTL formula CF
+ * Output: C++ source of an evaluator specialized to CF, exporting
+ *
+ *   extern "C" int mltl_evaluate(const char* rows, long length, long width);
+ *
+ * rows holds length timesteps of width characters each, back to back
+ * ('0' is false, anything else true). It returns the verdict of CF on the
+ * trace, the same as evaluate(), or -1 if CF reads a variable >= width.
+ * Interval bounds are compiled in as constants and every operator becomes
+ * straight-line code: boolean connectives are fused into expressions over
+ * the trace and only temporal operators keep truth values, for exactly the
+ * positions the verdict at 0 can look at. Since those positions are known
+ * from the bounds, the work per trace does not grow with its length.
+ * Built with -DMLTL_CODEGEN_MAIN the source is also a standalone program
+ * that reads traces in the multiple traces format, one per line.
+ */
+string generate_evaluator(const CompiledFormula& CF);
@@ -0,0 +1,119 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <dlfcn.h>
+#include "utils.h"
+#include "evaluate_mltl.h"
+#include "evaluate_dp.h"
+#include "codegen.h"
+
+using namespace std;
+
+/*
+ * Times evaluators generated by mltl_codegen against the generic engines
+ * over many traces of the same formula.
+ * Usage: codegen_benchmark [number of traces] [trace length]
+ * Every generated evaluator is built with g++ into a shared object under
+ * /tmp and loaded with dlopen, so g++ has to be on the path.
+ */
+
+typedef int (*GeneratedEvaluator)(const char*, long, long);
+
+static vector<vector<string>> random_traces(int count, int length, int n, unsigned seed) {
+    mt19937 gen(seed);
+    vector<vector<string>> traces(count, vector<string>(length, string(n, '0')));
+    for (vector<string>& trace : traces) {
+        for (string& row : trace) {
+            for (char& c : row) {
+                c = (gen() % 4 == 0) ? '1' : '0';
+            }
+        }
+    }
+    return traces;
+}
+
+template <typename F>
+static double time_ms(F f) {
+    auto start = chrono::steady_clock::now();
+    f();
+    auto end = chrono::steady_clock::now();
+    return chrono::duration<double, milli>(end - start).count();
+}
+
+/*
+ * Generates, builds and loads the evaluator of CF
+ */
+static GeneratedEvaluator build_evaluator(const CompiledFormula& CF, int index) {
+    string base = "/tmp/mltl_codegen_benchmark_" + to_string(index);
+    ofstream out(base + ".cpp");
+    out << generate_evaluator(CF);
+    out.close();
+    string command = "g++ -O2 -std=c++17 -shared -fPIC " + base + ".cpp -o " + base + ".so";
+    if (system(command.c_str()) != 0) {
+        throw runtime_error("Could not build " + base + ".cpp.");
+    }
+    void* library = dlopen((base + ".so").c_str(), RTLD_NOW);
+    if (library == nullptr) {
+        throw runtime_error(dlerror());
+    }
+    return (GeneratedEvaluator) dlsym(library, "mltl_evaluate");
+}
+
+int main(int argc, char** argv) {
+    int count = (argc > 1) ? stoi(argv[1]) : 100000;
+    int length = (argc > 2) ? stoi(argv[2]) : 100;
+
+    cout << "traces: " << count << ", trace length: " << length << endl;
+    // dataset-style specifications over a few variables
+    vector<string> formulas = {"G[0,20](p0->F[1,10]p1)",
+                               "(((true)U[0,30](p0))&G[5,40](p1|!p2))",
+                               "(G[0,10](p0R[0,5]p1)|F[0,50](p2&!p0))"};
+    vector<vector<string>> traces = random_traces(count, length, 3, 42);
+    // the generated code takes every trace as one flat block of rows
+    vector<string> flat;
+    for (const vector<string>& trace : traces) {
+        string rows;
+        for (const string& row : trace) {
+            rows += row;
+        }
+        flat.push_back(rows);
+    }
+
+    cout << "formula\trecursive (ms)\tdp (ms)\tgenerated (ms)\tsatisfied" << endl;
+    for (int f = 0; f < formulas.size(); ++f) {
+        CompiledFormula compiled = compile_mltl(formulas[f]);
+        GeneratedEvaluator generated = build_evaluator(compiled, f);
+
+        vector<char> recursive_verdicts(count), dp_verdicts(count), generated_verdicts(count);
+        double recursive_ms = time_ms([&]() {
+            for (int i = 0; i < count; ++i) {
+                recursive_verdicts[i] = evaluate(compiled, traces[i]);
+            }
+        });
+        double dp_ms = time_ms([&]() {
+            for (int i = 0; i < count; ++i) {
+                dp_verdicts[i] = evaluate_dp(compiled, traces[i]);
+            }
+        });
+        double generated_ms = time_ms([&]() {
+            for (int i = 0; i < count; ++i) {
+                generated_verdicts[i] = generated(flat[i].data(), length, 3);
+            }
+        });
+        if (recursive_verdicts != dp_verdicts || recursive_verdicts != generated_verdicts) {
+            cout << "verdict mismatch for " << formulas[f] << endl;
+            return 1;
+        }
+        long satisfied = 0;
+        for (char v : recursive_verdicts) {
+            satisfied += v;
+        }
+        cout << formulas[f] << "\t" << recursive_ms << "\t" << dp_ms << "\t" << generated_ms << "\t" << satisfied
+             << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,281 @@
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include <cctype>
+#include "compile_mltl.h"
+
+using namespace std;
+
+/*
+throws the error reported for every malformed formula
+*/
+static void invalid_formula(const string& F, int begin, int end) {
+    throw invalid_argument("Formula " + F.substr(begin, end-begin) + " is not a valid MLTL formula.");
+}
+
+/*
+checks if F[begin:end] is a number
+*/
+static bool digit_check(const string& F, int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+        if (F[i] < '0' || F[i] > '9') {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+checks if F[begin:end] is "p" followed by a digit
+*/
+static bool prop_var_check(const string& F, int begin, int end) {
+    if (end - begin < 2) {
+        return false;
+    }
+    if (F[begin] != 'p') {
+        return false;
+    }
+    return digit_check(F, begin+1, end);
+}
+
+/*
+checks if F[begin:end] is a signal name, a lowercase letter or '_'
+followed by lowercase letters, digits or '_'
+*/
+static bool signal_name_check(const string& F, int begin, int end) {
+    if (end - begin < 1 || !(islower(F[begin]) || F[begin] == '_')) {
+        return false;
+    }
+    for (int i = begin+1; i < end; ++i) {
+        if (!(islower(F[i]) || isdigit(F[i]) || F[i] == '_')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+finds lb and ub of first occurence of interval bound in F[begin:end],
+and the index of its closing brace
+*/
+static void find_bounds(const string& F, int begin, int end, int& lb, int& ub, int& rbrace) {
+    int lbrace = -1, comma = -1;
+    rbrace = -1;
+    for (int i = begin; i < end; ++i) {
+        if (F[i] == '[' && lbrace == -1) {
+            lbrace = i;
+        } else if (F[i] == ',' && comma == -1) {
+            comma = i;
+        } else if (F[i] == ']' && rbrace == -1) {
+            rbrace = i;
+        }
+    }
+    if (lbrace == -1 || comma == -1 || rbrace == -1) {
+        invalid_formula(F, begin, end);
+    }
+    try {
+        lb = stoi(F.substr(lbrace+1, comma-lbrace-1));
+        ub = stoi(F.substr(comma+1, rbrace-comma-1));
+    } catch (const logic_error&) {
+        invalid_formula(F, begin, end);
+    }
+    if (lb < 0 || lb > ub) {
+        invalid_formula(F, begin, end);
+    }
+}
+
+/*
+finds index of binary connective in F[begin:end], -1 if there is none
+*/
+static int find_binary_conn(const string& F, int begin, int end) {
+    int pcounter = 0;
+    for (int i = begin+1; i < end-1; ++i) {
+        if (F[i] == '(') {
+            ++pcounter;
+        } else if (F[i] == ')') {
+            --pcounter;
+        }
+        if (pcounter == 0) {
+            if (F[i] == '|' || F[i] == '&' || F[i] == '-' || F[i] == 'U' || F[i] == 'R') {
+                return i;
+            }
+        }
+    }
+    return -1;
+}
+
+static int add_node(CompiledFormula& cf, MLTLNode node) {
+    cf.nodes.push_back(node);
+    return cf.nodes.size() - 1;
+}
+
+/*
+ Input: formula F[begin:end]
+ Output: index of the node compiled from F[begin:end]
+ Follows the same grammar as the original string evaluator, so every
+ formula it accepted compiles to the same tree.
+ */
+static int compile_rec(const string& F, int begin, int end, CompiledFormula& cf) {
+    if (begin >= end) {
+        invalid_formula(F, begin, end);
+    }
+    MLTLNode node;
+
+    // Prop_cons -> true | false
+    if (F.compare(begin, end-begin, "true") == 0) {
+        node.op = MLTLOp::TRUE_CONS;
+        return add_node(cf, node);
+    } else if (F.compare(begin, end-begin, "false") == 0) {
+        node.op = MLTLOp::FALSE_CONS;
+        return add_node(cf, node);
+    }
+
+    // Prop_var -> 'p' Num
+    else if (prop_var_check(F, begin, end)) {
+        node.op = MLTLOp::PROP_VAR;
+        try {
+            node.var = stoi(F.substr(begin+1, end-begin-1));
+        } catch (const logic_error&) {
+            invalid_formula(F, begin, end);
+        }
+        return add_node(cf, node);
+    }
+
+    // Prop_var -> 'a' Num, the same variable as 'p' Num
+    // Prop_var -> Name, a named signal
+    else if (signal_name_check(F, begin, end)) {
+        node.op = MLTLOp::PROP_VAR;
+        if (F[begin] == 'a' && end - begin >= 2 && digit_check(F, begin+1, end)) {
+            try {
+                node.var = stoi(F.substr(begin+1, end-begin-1));
+            } catch (const logic_error&) {
+                invalid_formula(F, begin, end);
+            }
+            return add_node(cf, node);
+        }
+        string name = F.substr(begin, end-begin);
+        auto it = find(cf.signals.begin(), cf.signals.end(), name);
+        if (it == cf.signals.end()) {
+            it = cf.signals.insert(it, name);
+        }
+        node.var = -1 - (int) (it - cf.signals.begin());
+        return add_node(cf, node);
+    }
+
+    // Unary_Prop_conn -> '~' | '!'
+    else if (F[begin] == '~' || F[begin] == '!') {
+        node.op = MLTLOp::NOT;
+        node.left = compile_rec(F, begin+1, end, cf);
+        return add_node(cf, node);
+    }
+
+    // Unary_Temp_conn -> 'F' | 'G'
+    else if (F[begin] == 'F' || F[begin] == 'G') {
+        int rbrace;
+        find_bounds(F, begin, end, node.lb, node.ub, rbrace);
+        node.op = (F[begin] == 'F') ? MLTLOp::FINALLY : MLTLOp::GLOBALLY;
+        node.left = compile_rec(F, rbrace+1, end, cf);
+        return add_node(cf, node);
+    }
+
+    // find first occurence of binary connective by counting parentheses
+    else if (F[begin] == '(') {
+        int binary_conn_index = find_binary_conn(F, begin, end);
+        if (binary_conn_index == -1) {
+            return compile_rec(F, begin+1, end-1, cf);
+        }
+        int conn = binary_conn_index;
+        int rest_end = end-1; // drop the closing parenthesis
+        int right_begin;
+        if (F[conn] == '&') {
+            node.op = MLTLOp::AND;
+            right_begin = conn+1;
+        } else if (F[conn] == '|') {
+            node.op = MLTLOp::OR;
+            right_begin = conn+1;
+        } else if (F[conn] == '-') {
+            if (conn+1 >= rest_end || F[conn+1] != '>') {
+                invalid_formula(F, conn, rest_end);
+            }
+            node.op = MLTLOp::IMPLIES;
+            right_begin = conn+2;
+        } else { // 'U' or 'R'
+            int rbrace;
+            find_bounds(F, conn, rest_end, node.lb, node.ub, rbrace);
+            node.op = (F[conn] == 'U') ? MLTLOp::UNTIL : MLTLOp::RELEASE;
+            right_begin = rbrace+1;
+        }
+        node.left = compile_rec(F, begin+1, conn, cf);
+        node.right = compile_rec(F, right_begin, rest_end, cf);
+        return add_node(cf, node);
+    }
+
+    // Formula is not a valid formula
+    invalid_formula(F, begin, end);
+    return -1;
+}
+
+/*
+ * Input: MLTL formula F, with whitespace already stripped
+ * Output: F compiled into a node tree
+ * Throws invalid_argument if F is not a valid MLTL formula.
+ */
+CompiledFormula compile_mltl(const string& F) {
+    CompiledFormula cf;
+    cf.root = compile_rec(F, 0, F.length(), cf);
+    return cf;
+}
+
+/*
+ * Returns true if and only if op is F, G, U or R
+ */
+bool is_temporal(MLTLOp op) {
+    return op == MLTLOp::FINALLY || op == MLTLOp::GLOBALLY
+        || op == MLTLOp::UNTIL || op == MLTLOp::RELEASE;
+}
+
+/*
+ * Returns true if and only if op is &, |, ->, U or R
+ */
+bool is_binary(MLTLOp op) {
+    return op == MLTLOp::AND || op == MLTLOp::OR || op == MLTLOp::IMPLIES
+        || op == MLTLOp::UNTIL || op == MLTLOp::RELEASE;
+}
+
+/*
+ * Converts a compiled formula (or the subformula rooted at node) back to
+ * the interpreter's fully parenthesized syntax
+ */
+string formula_to_string(const CompiledFormula& cf, int node) {
+    const MLTLNode& n = cf.nodes[node];
+    string interval = "[" + to_string(n.lb) + "," + to_string(n.ub) + "]";
+    switch (n.op) {
+        case MLTLOp::TRUE_CONS:
+            return "true";
+        case MLTLOp::FALSE_CONS:
+            return "false";
+        case MLTLOp::PROP_VAR:
+            return (n.var < 0) ? cf.signals[-n.var-1] : "p" + to_string(n.var);
+        case MLTLOp::NOT:
+            return "!" + formula_to_string(cf, n.left);
+        case MLTLOp::FINALLY:
+            return "F" + interval + formula_to_string(cf, n.left);
+        case MLTLOp::GLOBALLY:
+            return "G" + interval + formula_to_string(cf, n.left);
+        case MLTLOp::AND:
+            return "(" + formula_to_string(cf, n.left) + "&" + formula_to_string(cf, n.right) + ")";
+        case MLTLOp::OR:
+            return "(" + formula_to_string(cf, n.left) + "|" + formula_to_string(cf, n.right) + ")";
+        case MLTLOp::IMPLIES:
+            return "(" + formula_to_string(cf, n.left) + "->" + formula_to_string(cf, n.right) + ")";
+        case MLTLOp::UNTIL:
+            return "(" + formula_to_string(cf, n.left) + "U" + interval + formula_to_string(cf, n.right) + ")";
+        case MLTLOp::RELEASE:
+            return "(" + formula_to_string(cf, n.left) + "R" + interval + formula_to_string(cf, n.right) + ")";
+    }
+    return "";
+}
+string formula_to_string(const CompiledFormula& cf) {
+    return formula_to_string(cf, cf.root);
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/*
+ * Operators of a compiled MLTL formula
+ */
+enum class MLTLOp {
+    TRUE_CONS,  // true
+    FALSE_CONS, // false
+    PROP_VAR,   // p0, p1, ...
+    NOT,        // ! or ~
+    FINALLY,    // F[lb,ub]
+    GLOBALLY,   // G[lb,ub]
+    AND,        // &
+    OR,         // |
+    IMPLIES,    // ->
+    UNTIL,      // U[lb,ub]
+    RELEASE,    // R[lb,ub]
+};
+
+/*
+ * A single node of a compiled formula.
+ * Operands are indices into CompiledFormula::nodes, -1 if unused.
+ */
+struct MLTLNode {
+    MLTLOp op;
+    int var = -1;   // propositional variable index for PROP_VAR, see signals
+    int lb = 0;     // interval bounds for F, G, U, R
+    int ub = 0;
+    int left = -1;  // operand of unary connectives, left operand of binary ones
+    int right = -1; // right operand of binary connectives
+};
+
+/*
+ * An MLTL formula parsed once into a node tree.
+ * Nodes are stored in post-order, so every operand precedes its parent
+ * and the root is the last node.
+ */
+struct CompiledFormula {
+    vector<MLTLNode> nodes;
+    int root = -1;
+    // named signals in order of first use. A PROP_VAR node with var < 0
+    // reads signal signals[-var-1], which bind_signals() (signal_store.h)
+    // turns into a column index before the formula can be evaluated.
+    vector<string> signals;
+};
+
+/*
+ * Input: MLTL formula F, with whitespace already stripped
+ * Output: F compiled into a node tree
+ * Variables are 'p' or 'a' followed by a column index (p3 and a3 are the
+ * same variable), or signal names: a lowercase letter or '_' followed by
+ * lowercase letters, digits and '_', other than true and false.
+ * Throws invalid_argument if F is not a valid MLTL formula.
+ */
+CompiledFormula compile_mltl(const string& F);
+
+/*
+ * Returns true if and only if op is F, G, U or R
+ */
+bool is_temporal(MLTLOp op);
+
+/*
+ * Returns true if and only if op is &, |, ->, U or R
+ */
+bool is_binary(MLTLOp op);
+
+/*
+ * Converts a compiled formula (or the subformula rooted at node) back to
+ * the interpreter's fully parenthesized syntax
+ */
+string formula_to_string(const CompiledFormula& cf);
+string formula_to_string(const CompiledFormula& cf, int node);
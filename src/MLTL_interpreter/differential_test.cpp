@@ -0,0 +1,205 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <random>
+#include <cstdlib>
+#include <dlfcn.h>
+#include "utils.h"
+#include "compile_mltl.h"
+#include "simplify.h"
+#include "evaluate_mltl.h"
+#include "evaluate_dp.h"
+#include "evaluate_bits.h"
+#include "evaluate_sliced.h"
+#include "evaluate_rle.h"
+#include "eval_session.h"
+#include "stream_monitor.h"
+#include "formula_dag.h"
+#include "codegen.h"
+
+using namespace std;
+
+/*
+ * Differential test of the evaluation engines against the default
+ * recursive evaluate() on random formulas and traces.
+ * Usage: differential_test [number of formulas] [seed]
+ * Trace lengths sit around the word boundaries of the bit-packed engines.
+ * Every formula is checked as parsed and simplified, with every engine
+ * flag, '-dp' on several threads, '-sliced' over all lengths in one batch,
+ * the stream monitor, evaluation sessions and the formula DAG on every
+ * suffix, and for a few formulas the evaluator of mltl_codegen, built with
+ * g++ into a shared object under /tmp. Prints every mismatch and exits
+ * with 1 if there was one.
+ */
+
+typedef int (*GeneratedEvaluator)(const char*, long, long);
+
+static const int num_vars = 3;
+static const size_t lengths[] = {1, 2, 3, 63, 64, 65, 127, 128, 129};
+
+static string bounds(mt19937& gen) {
+    // wide enough for a window to cross a word boundary
+    int lb = gen() % 4 == 0 ? gen() % 66 : gen() % 6;
+    int ub = lb + (gen() % 3 == 0 ? 60 + gen() % 10 : gen() % 6);
+    return "[" + to_string(lb) + "," + to_string(ub) + "]";
+}
+
+static string random_formula(mt19937& gen, int depth) {
+    if (depth == 0 || gen() % 4 == 0) {
+        int leaf = gen() % (num_vars + 2);
+        if (leaf == num_vars) {
+            return "true";
+        }
+        if (leaf == num_vars + 1) {
+            return "false";
+        }
+        return "p" + to_string(leaf);
+    }
+    switch (gen() % 9) {
+    case 0:
+        return "!(" + random_formula(gen, depth - 1) + ")";
+    case 1:
+        return "F" + bounds(gen) + "(" + random_formula(gen, depth - 1) + ")";
+    case 2:
+        return "G" + bounds(gen) + "(" + random_formula(gen, depth - 1) + ")";
+    case 3:
+        return "((" + random_formula(gen, depth - 1) + ")&(" + random_formula(gen, depth - 1) + "))";
+    case 4:
+        return "((" + random_formula(gen, depth - 1) + ")|(" + random_formula(gen, depth - 1) + "))";
+    case 5:
+        return "((" + random_formula(gen, depth - 1) + ")->(" + random_formula(gen, depth - 1) + "))";
+    case 6:
+        return "((" + random_formula(gen, depth - 1) + ")U" + bounds(gen) + "(" + random_formula(gen, depth - 1) + "))";
+    case 7:
+        return "((" + random_formula(gen, depth - 1) + ")R" + bounds(gen) + "(" + random_formula(gen, depth - 1) + "))";
+    default: {
+        // a repeated operand and a nested interval, for the simplifier
+        string operand = random_formula(gen, depth - 1);
+        return "((G" + bounds(gen) + "(G" + bounds(gen) + "(" + operand + ")))&((" + operand + ")U" + bounds(gen) +
+               "(" + operand + ")))";
+    }
+    }
+}
+
+static vector<string> random_trace(mt19937& gen, size_t length) {
+    // p0 changes rarely, so that F and G windows are not decided at once,
+    // p2 about every other timestep
+    vector<string> trace(length, string(num_vars, '0'));
+    const unsigned period[num_vars] = {40, 5, 2};
+    for (int p = 0; p < num_vars; ++p) {
+        char value = '0';
+        for (size_t t = 0; t < length; ++t) {
+            if (gen() % period[p] == 0) {
+                value = (value == '0') ? '1' : '0';
+            }
+            trace[t][p] = value;
+        }
+    }
+    return trace;
+}
+
+/*
+ * Generates, builds and loads the evaluator of CF
+ */
+static GeneratedEvaluator build_evaluator(const CompiledFormula& CF, int index) {
+    string base = "/tmp/mltl_differential_test_" + to_string(index);
+    ofstream out(base + ".cpp");
+    out << generate_evaluator(CF);
+    out.close();
+    string command = "g++ -O1 -std=c++17 -shared -fPIC " + base + ".cpp -o " + base + ".so";
+    if (system(command.c_str()) != 0) {
+        throw runtime_error("Could not build " + base + ".cpp.");
+    }
+    void* library = dlopen((base + ".so").c_str(), RTLD_NOW);
+    if (library == nullptr) {
+        throw runtime_error(dlerror());
+    }
+    return (GeneratedEvaluator) dlsym(library, "mltl_evaluate");
+}
+
+static int mismatches = 0;
+
+static void check(bool verdict, bool expected, const string& engine, const string& formula, size_t length,
+                  size_t suffix = 0) {
+    if (verdict != expected) {
+        ++mismatches;
+        cout << "mismatch: " << engine << " on " << formula << ", trace length " << length << ", suffix " << suffix
+             << ": " << verdict << " instead of " << expected << endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    int count = (argc > 1) ? stoi(argv[1]) : 300;
+    unsigned seed = (argc > 2) ? stoul(argv[2]) : 1;
+    const int codegen_every = 30;
+    const vector<string> flags = {"-memo", "-dp", "-bits", "-sliced", "-rle"};
+
+    mt19937 gen(seed);
+    for (int f = 0; f < count; ++f) {
+        const string formula = random_formula(gen, 3);
+        const CompiledFormula parsed = compile_mltl(formula);
+        const CompiledFormula simplified = simplify(parsed);
+        vector<vector<string>> traces;
+        for (size_t length : lengths) {
+            traces.push_back(random_trace(gen, length));
+        }
+
+        GeneratedEvaluator generated = nullptr;
+        if (f % codegen_every == 0) {
+            generated = build_evaluator(simplified, f);
+        }
+        const FormulaDAG dag = build_dag({parsed, simplified});
+        vector<TraceView> views(traces.begin(), traces.end());
+        const vector<bool> sliced = evaluate_sliced(simplified, views);
+
+        for (size_t i = 0; i < traces.size(); ++i) {
+            const vector<string>& trace = traces[i];
+            const size_t length = trace.size();
+            // the reference, evaluate() on every suffix of the parsed formula
+            vector<bool> expected(length);
+            for (size_t t = 0; t < length; ++t) {
+                expected[t] = evaluate(parsed, TraceView(trace).suffix(t));
+            }
+
+            check(evaluate(simplified, trace), expected[0], "simplify", formula, length);
+            for (const string& flag : flags) {
+                Engine engine;
+                parse_engine_flag(flag, engine);
+                check(evaluate(parsed, trace, engine), expected[0], flag, formula, length);
+                check(evaluate(simplified, trace, engine), expected[0], flag + " simplified", formula, length);
+            }
+            check(evaluate_dp_parallel(simplified, trace, 3), expected[0], "-dp -j 3", formula, length);
+            check(sliced[i], expected[0], "-sliced batch", formula, length);
+            if (generated != nullptr) {
+                string rows;
+                for (const string& row : trace) {
+                    rows += row;
+                }
+                check(generated(rows.data(), length, num_vars) == 1, expected[0], "mltl_codegen", formula, length);
+            }
+
+            const vector<bool> by_dag = evaluate_dag(dag, trace);
+            check(by_dag[0], expected[0], "dag", formula, length);
+            check(by_dag[1], expected[0], "dag simplified", formula, length);
+
+            // one timestep at a time, and in two appends split at the middle
+            StreamMonitor monitor(simplify(parsed, false));
+            vector<bool> streamed;
+            for (const string& row : trace) {
+                monitor.push(row, streamed);
+            }
+            monitor.finish(streamed);
+            EvalSession session(simplified);
+            session.append(vector<string>(trace.begin(), trace.begin() + length / 2));
+            const TruthVector& appended = session.append(vector<string>(trace.begin() + length / 2, trace.end()));
+            for (size_t t = 0; t < length; ++t) {
+                check(streamed[t], expected[t], "--stream", formula, length, t);
+                check(appended[t], expected[t], "session", formula, length, t);
+            }
+        }
+    }
+
+    cout << count << " formulas, " << mismatches << " mismatches" << endl;
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "eval_session.h"
+#include "stream_monitor.h"
+#include "utils.h"
+
+using namespace std;
+
+EvalSession::EvalSession(const CompiledFormula& CF) : formula(CF), vectors(CF.nodes.size()) {
+    for (int i = 0; i < CF.nodes.size(); ++i) {
+        reach.push_back(future_reach(CF, i));
+    }
+    // truth vectors of the empty trace
+    for (int i = 0; i < CF.nodes.size(); ++i) {
+        const MLTLNode& n = CF.nodes[i];
+        if (n.op == MLTLOp::PROP_VAR) {
+            vectors[i].assign(1, 0);
+        } else {
+            const TruthVector* left = (n.left == -1) ? nullptr : &vectors[n.left];
+            const TruthVector* right = (n.right == -1) ? nullptr : &vectors[n.right];
+            vectors[i].assign(1, 0);
+            compute_truth_vector(n, 0, left, right, vectors[i]);
+        }
+    }
+}
+
+const TruthVector& EvalSession::append(const vector<string>& rows) {
+    const size_t old_length = count;
+    vector<string> stripped;
+    for (const string& row : rows) {
+        stripped.push_back(strip_char(strip_char(row, ' '), ','));
+    }
+    // check every row before touching any vector, so a bad append changes nothing
+    for (const MLTLNode& n : formula.nodes) {
+        for (const string& row : stripped) {
+            if (n.op == MLTLOp::PROP_VAR && n.var >= row.length()) {
+                throw invalid_argument("Propositional variable p" + to_string(n.var) + " is out of bounds of the trace.");
+            }
+        }
+    }
+    count += stripped.size();
+
+    for (int i = 0; i < formula.nodes.size(); ++i) {
+        const MLTLNode& n = formula.nodes[i];
+        TruthVector& out = vectors[i];
+        if (n.op == MLTLOp::PROP_VAR) {
+            // the old empty suffix becomes the first new timestep
+            out.resize(count + 1);
+            for (size_t t = old_length; t < count; ++t) {
+                out[t] = stripped[t - old_length][n.var] != '0';
+            }
+            out[count] = 0;
+            continue;
+        }
+        // the verdict at t only depends on the end of the trace while
+        // t + reach >= old_length, the positions before are final
+        size_t from = (old_length > reach[i]) ? old_length - reach[i] : 0;
+        const TruthVector* left = (n.left == -1) ? nullptr : &vectors[n.left];
+        const TruthVector* right = (n.right == -1) ? nullptr : &vectors[n.right];
+        out.resize(count + 1);
+        compute_truth_vector(n, count, left, right, out, from);
+    }
+    size_t root_reach = reach[formula.root];
+    changed = (old_length > root_reach) ? old_length - root_reach : 0;
+    return vectors[formula.root];
+}
+
+const TruthVector& EvalSession::verdicts() const {
+    return vectors[formula.root];
+}
+
+size_t EvalSession::changed_from() const {
+    return changed;
+}
+
+size_t EvalSession::length() const {
+    return count;
+}
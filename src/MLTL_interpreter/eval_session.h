@@ -0,0 +1,48 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "compile_mltl.h"
+#include "evaluate_dp.h"
+
+using namespace std;
+
+/*
+ * Evaluation of one formula over a trace that keeps growing.
+ * The session holds the truth vector of every subformula. Appending
+ * timesteps only recomputes the positions of a subformula whose verdict can
+ * still depend on the end of the trace, the last future_reach of them plus
+ * the new ones, so an append of k timesteps costs O(|CF| * (future_reach + k))
+ * however long the trace already is. After every append the verdicts are
+ * those of evaluate() on every suffix of the trace read so far.
+ */
+class EvalSession {
+public:
+    explicit EvalSession(const CompiledFormula& CF);
+
+    /*
+     * Appends the timesteps in rows and returns the updated verdicts of the
+     * formula, entry t being the verdict on the suffix starting at t
+     * (entry length() is the empty suffix). ' ' and ',' in rows are ignored.
+     */
+    const TruthVector& append(const vector<string>& rows);
+
+    /*
+     * Verdicts after the last append, entries before changed_from() were
+     * left as they were by it
+     */
+    const TruthVector& verdicts() const;
+    size_t changed_from() const;
+
+    /*
+     * Number of timesteps appended so far
+     */
+    size_t length() const;
+
+private:
+    CompiledFormula formula;
+    vector<TruthVector> vectors;
+    // future_reach of every node
+    vector<size_t> reach;
+    size_t count = 0;
+    size_t changed = 0;
+};
@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <vector>
+#include <stdexcept>
+#include "evaluate_bits.h"
+#include "evaluate_dp.h"
+
+using namespace std;
+
+static TruthVector unpack(const BitVector& v, size_t N) {
+    TruthVector out(N+1);
+    for (size_t t = 0; t <= N; ++t) {
+        out[t] = get_bit(v.data(), t);
+    }
+    return out;
+}
+
+static BitVector pack(const TruthVector& v, size_t words) {
+    BitVector out(words, 0);
+    for (size_t t = 0; t < v.size(); ++t) {
+        if (v[t]) {
+            set_bit(out.data(), t, true);
+        }
+    }
+    return out;
+}
+
+/*
+ * Computes the bit vector of node n from the bit vectors of its operands.
+ * All vectors cover positions [0, N] and keep bits past N zero.
+ */
+static void compute_bit_vector(const MLTLNode& n, const PackedTrace& P, const BitVector* left,
+                               const BitVector* right, BitVector& out) {
+    const size_t N = P.length;
+    const size_t W = P.words;
+    const size_t lb = n.lb, ub = n.ub;
+    out.assign(W, 0);
+    switch (n.op) {
+    case MLTLOp::TRUE_CONS:
+        set_range(out.data(), 0, N+1, true);
+        break;
+    case MLTLOp::FALSE_CONS:
+        break;
+
+    // false on the empty suffix, which pack_trace leaves as 0
+    case MLTLOp::PROP_VAR:
+        if (n.var >= P.num_vars) {
+            if (N == 0) {
+                break;
+            }
+            throw invalid_argument("Propositional variable p" + to_string(n.var) + " is out of bounds of the trace.");
+        }
+        copy(P.column(n.var), P.column(n.var) + W, out.begin());
+        break;
+
+    case MLTLOp::NOT:
+        bits_not(left->data(), out.data(), W);
+        set_range(out.data(), N+1, W*64, false);
+        break;
+    case MLTLOp::AND:
+        bits_and(left->data(), right->data(), out.data(), W);
+        break;
+    case MLTLOp::OR:
+        bits_or(left->data(), right->data(), out.data(), W);
+        break;
+    case MLTLOp::IMPLIES:
+        // !a | b == !(a & !b)
+        bits_andnot(left->data(), right->data(), out.data(), W);
+        bits_not(out.data(), out.data(), W);
+        set_range(out.data(), N+1, W*64, false);
+        break;
+
+    // out[t] = OR of subF over [t+a, min(t+b, N-1)]: drop the empty
+    // suffix bit, slide a window of width b-a+1 and shift it down by a
+    case MLTLOp::FINALLY: {
+        BitVector sub = *left;
+        set_bit(sub.data(), N, false);
+        BitVector window(W);
+        bits_window_or(sub.data(), window.data(), W, ub - lb + 1);
+        bits_shift_down(window.data(), out.data(), W, lb, false);
+        break;
+    }
+
+    // out[t] = t+a >= N or AND of subF over [t+a, min(t+b, N)]:
+    // positions past N count as true inside the window
+    case MLTLOp::GLOBALLY: {
+        BitVector sub = *left;
+        set_range(sub.data(), N+1, W*64, true);
+        BitVector window(W);
+        bits_window_and(sub.data(), window.data(), W, ub - lb + 1);
+        bits_shift_down(window.data(), out.data(), W, lb, true);
+        set_range(out.data(), (N > lb) ? N - lb : 0, N+1, true);
+        set_range(out.data(), N+1, W*64, false);
+        break;
+    }
+
+    // U and R need the first witness in the window, use the DP kernels
+    case MLTLOp::UNTIL:
+    case MLTLOp::RELEASE: {
+        TruthVector l = unpack(*left, N), r = unpack(*right, N), result(N+1);
+        compute_truth_vector(n, N, &l, &r, result);
+        out = pack(result, W);
+        break;
+    }
+    }
+}
+
+/*
+ * Input: compiled MLTL formula CF
+ *        bit-packed trace P
+ * Output: bit vector of every node of CF over positions [0, P.length],
+ *         indexed like CF.nodes (same meaning as truth_vectors)
+ */
+vector<BitVector> bit_vectors(const CompiledFormula& CF, const PackedTrace& P) {
+    vector<BitVector> vectors(CF.nodes.size());
+    for (int i = 0; i < CF.nodes.size(); ++i) {
+        const MLTLNode& n = CF.nodes[i];
+        const BitVector* left = (n.left == -1) ? nullptr : &vectors[n.left];
+        const BitVector* right = (n.right == -1) ? nullptr : &vectors[n.right];
+        compute_bit_vector(n, P, left, right, vectors[i]);
+    }
+    return vectors;
+}
+
+/*
+ * Input: compiled MLTL formula CF
+ *        bit-packed trace P
+ * Output: true if and only if CF evaluates to true on P
+ */
+bool evaluate_bits(const CompiledFormula& CF, const PackedTrace& P) {
+    return get_bit(bit_vectors(CF, P)[CF.root].data(), 0);
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <vector>
+#include "compile_mltl.h"
+#include "packed_trace.h"
+
+using namespace std;
+
+/*
+ * Input: compiled MLTL formula CF
+ *        bit-packed trace P
+ * Output: bit vector of every node of CF over positions [0, P.length],
+ *         indexed like CF.nodes (same meaning as truth_vectors)
+ * Boolean connectives and F/G windows run on whole words; U and R go
+ * through the width-independent DP kernels.
+ */
+vector<BitVector> bit_vectors(const CompiledFormula& CF, const PackedTrace& P);
+
+/*
+ * Input: compiled MLTL formula CF
+ *        bit-packed trace P
+ * Output: true if and only if CF evaluates to true on P
+ */
+bool evaluate_bits(const CompiledFormula& CF, const PackedTrace& P);
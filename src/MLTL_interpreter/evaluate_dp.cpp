@@ -0,0 +1,251 @@
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <chrono>
+#include "evaluate_dp.h"
+#include "work_pool.h"
+
+using namespace std;
+
+/*
+ * First positions at or after t holding a given value, for t >= base only,
+ * so that recomputing the tail of a truth vector costs the tail alone.
+ * Lookups past the last position scanned answer one past it.
+ */
+struct NextIndex {
+    long base;
+    vector<long> next;
+    long operator[](long t) const { return next[t - base]; }
+};
+
+/*
+ * Input: truth vector V of length N+1
+ *        value v
+ *        first position from that will be looked up
+ *        last position last that is scanned
+ * Output: entry t is the first position s in [t, last] with V[s] == v,
+ *         or last+1 if there is none
+ * Lets every windowed operator answer "is there a v in [lo, hi]" in O(1),
+ * independent of the interval width, as long as hi <= last.
+ */
+static NextIndex next_index(const TruthVector& V, char v, long from, long last) {
+    long N = V.size() - 1;
+    last = min(last, N);
+    from = min(from, last+1);
+    NextIndex next{from, vector<long>(last+2-from)};
+    next.next[last+1-from] = last+1;
+    for (long t = last; t >= from; --t) {
+        next.next[t-from] = (V[t] == v) ? t : next.next[t+1-from];
+    }
+    return next;
+}
+
+/*
+ * Positions [from, to) of the truth vector of var, out already sized
+ */
+static void load_prop_var(int var, TraceView T, TruthVector& out, size_t from, size_t to) {
+    for (size_t t = from; t < to; ++t) {
+        if (var >= T[t].length()) {
+            throw invalid_argument("Propositional variable p" + to_string(var) + " is out of bounds of the trace.");
+        }
+        out[t] = T[t][var] != '0';
+    }
+}
+
+/*
+ * Truth vector of propositional variable var over trace T,
+ * false on the empty suffix
+ */
+void load_prop_var(int var, TraceView T, TruthVector& out) {
+    out.assign(T.size()+1, 0);
+    load_prop_var(var, T, out, 0, T.size());
+}
+
+/*
+ * Computes the truth vector of node n from the truth vectors of its operands.
+ * left/right are null for operands n does not have.
+ * out must already hold trace_length+1 entries, only positions [from, to)
+ * are written, so chunks of one vector can be computed concurrently.
+ * n must not be a propositional variable, those are read from the trace
+ * with load_prop_var.
+ */
+void compute_truth_vector(const MLTLNode& n, size_t trace_length, const TruthVector* left,
+                          const TruthVector* right, TruthVector& out, size_t from, size_t to) {
+    const long N = trace_length;
+    const long lb = n.lb, ub = n.ub;
+    const long t0 = from;
+    // last position computed, windows read the operands up to ub past it
+    const long t1 = min((long) min(to, trace_length + 1) - 1, N);
+    const long last = min(t1 + ub, N);
+    if (t1 < t0) {
+        return;
+    }
+    fill(out.begin() + t0, out.begin() + t1 + 1, 0);
+    switch (n.op) {
+
+    // Prop_cons -> true | false
+    case MLTLOp::TRUE_CONS:
+        fill(out.begin() + t0, out.begin() + t1 + 1, 1);
+        break;
+    case MLTLOp::FALSE_CONS:
+        break;
+
+    // Prop_var -> 'p' Num, needs the trace itself
+    case MLTLOp::PROP_VAR:
+        throw invalid_argument("Propositional variables are loaded with load_prop_var.");
+
+    case MLTLOp::NOT:
+        for (long t = t0; t <= t1; ++t) {
+            out[t] = !(*left)[t];
+        }
+        break;
+    case MLTLOp::AND:
+        for (long t = t0; t <= t1; ++t) {
+            out[t] = (*left)[t] && (*right)[t];
+        }
+        break;
+    case MLTLOp::OR:
+        for (long t = t0; t <= t1; ++t) {
+            out[t] = (*left)[t] || (*right)[t];
+        }
+        break;
+    case MLTLOp::IMPLIES:
+        for (long t = t0; t <= t1; ++t) {
+            out[t] = !(*left)[t] || (*right)[t];
+        }
+        break;
+
+    // T[t:] |- F[a, b] subF iff n > a and there exists i in [a, min(b, n-1)]
+    // such that T[t+i:] |- subF, where n = |T[t:]|
+    case MLTLOp::FINALLY: {
+        NextIndex next_true = next_index(*left, 1, t0 + lb, last);
+        for (long t = t0; t <= t1 && t + lb < N; ++t) {
+            out[t] = next_true[t+lb] <= min(t+ub, N-1);
+        }
+        break;
+    }
+
+    // T[t:] |- G[a, b] subF iff n <= a or for all i in [a, min(b, n)],
+    // T[t+i:] |- subF. Like the recursive evaluator, i = n (the empty
+    // suffix) is included when b >= n.
+    case MLTLOp::GLOBALLY: {
+        NextIndex next_false = next_index(*left, 0, t0 + lb, last);
+        for (long t = t0; t <= t1; ++t) {
+            out[t] = (t + lb >= N) || next_false[t+lb] > min(t+ub, N);
+        }
+        break;
+    }
+
+    // T[t:] |- F1 U[a,b] F2 iff n > a and for the first i in [a, min(b, n-1)]
+    // with T[t+i:] |- F2, T[t+j:] |- F1 for all j in [a, i-1]
+    case MLTLOp::UNTIL: {
+        NextIndex next_true2 = next_index(*right, 1, t0 + lb, last);
+        NextIndex next_false1 = next_index(*left, 0, t0 + lb, last);
+        for (long t = t0; t <= t1 && t + lb < N; ++t) {
+            long i = next_true2[t+lb];
+            out[t] = i <= min(t+ub, N-1) && next_false1[t+lb] >= i;
+        }
+        break;
+    }
+
+    // T[t:] |- F1 R[a,b] F2 iff n <= a or for all i in [a, min(b, n-1)]
+    // T[t+i:] |- F2 or (there exists j in [a, min(b-1, n-1)] such that
+    // T[t+j:] |- F1 and for all k in [a, j], T[t+k:] |- F2)
+    case MLTLOp::RELEASE: {
+        NextIndex next_false2 = next_index(*right, 0, t0 + lb, last);
+        NextIndex next_true1 = next_index(*left, 1, t0 + lb, last);
+        for (long t = t0; t <= t1; ++t) {
+            if (t + lb >= N) {
+                out[t] = 1;
+                continue;
+            }
+            // first violation of F2, F1 must hold strictly before it
+            long k = next_false2[t+lb];
+            out[t] = k > min(t+ub, N-1) || next_true1[t+lb] < k;
+        }
+        break;
+    }
+    }
+}
+
+/*
+ * Input: compiled MLTL formula CF
+ *        trace T
+ * Output: truth vector of every node of CF, indexed like CF.nodes,
+ *         computed bottom-up in post-order
+ */
+vector<TruthVector> truth_vectors(const CompiledFormula& CF, TraceView T, Profile* profile) {
+    vector<TruthVector> vectors(CF.nodes.size());
+    // time of every node of this call with its operands, when profiling
+    vector<double> total_ns(profile ? CF.nodes.size() : 0);
+    for (int i = 0; i < CF.nodes.size(); ++i) {
+        const MLTLNode& n = CF.nodes[i];
+        const TruthVector* left = (n.left == -1) ? nullptr : &vectors[n.left];
+        const TruthVector* right = (n.right == -1) ? nullptr : &vectors[n.right];
+        auto start = profile ? chrono::steady_clock::now() : chrono::steady_clock::time_point();
+        if (n.op == MLTLOp::PROP_VAR) {
+            load_prop_var(n.var, T, vectors[i]);
+        } else {
+            vectors[i].assign(T.size()+1, 0);
+            compute_truth_vector(n, T.size(), left, right, vectors[i]);
+        }
+        if (profile) {
+            double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+            total_ns[i] = ns + ((n.left == -1) ? 0 : total_ns[n.left]) + ((n.right == -1) ? 0 : total_ns[n.right]);
+            NodeProfile& p = profile->nodes[i];
+            p.evaluations += T.size() + 1;
+            p.self_ns += ns;
+            p.total_ns += total_ns[i];
+        }
+    }
+    return vectors;
+}
+
+/*
+ * Input: compiled MLTL formula CF
+ *        trace T
+ * Output: true if and only if CF evaluates to true on T
+ */
+bool evaluate_dp(const CompiledFormula& CF, TraceView T) {
+    return truth_vectors(CF, T)[CF.root][0];
+}
+
+/*
+ * Input: compiled MLTL formula CF
+ *        trace T
+ *        number of threads
+ * Output: truth vector of every node of CF, as truth_vectors() computes them
+ */
+vector<TruthVector> truth_vectors_parallel(const CompiledFormula& CF, TraceView T, int threads) {
+    // a few chunks per thread so that stealing evens them out, but not so
+    // small that a chunk costs less than handing it to a thread
+    const size_t positions = T.size() + 1;
+    const size_t min_chunk = 1 << 16;
+    size_t chunk = (positions + 4 * threads - 1) / (4 * threads);
+    chunk = max(chunk, min_chunk);
+    const size_t chunks = (positions + chunk - 1) / chunk;
+
+    vector<TruthVector> vectors(CF.nodes.size());
+    for (int i = 0; i < CF.nodes.size(); ++i) {
+        const MLTLNode& n = CF.nodes[i];
+        const TruthVector* left = (n.left == -1) ? nullptr : &vectors[n.left];
+        const TruthVector* right = (n.right == -1) ? nullptr : &vectors[n.right];
+        // sized up front, the chunks then write disjoint ranges of it
+        vectors[i].assign(positions, 0);
+        // the operands are complete, so a chunk may read past its end
+        parallel_for(chunks, threads, [&](size_t c) {
+            size_t from = c * chunk, to = min(from + chunk, positions);
+            if (n.op == MLTLOp::PROP_VAR) {
+                load_prop_var(n.var, T, vectors[i], from, min(to, T.size()));
+            } else {
+                compute_truth_vector(n, T.size(), left, right, vectors[i], from, to);
+            }
+        });
+    }
+    return vectors;
+}
+
+bool evaluate_dp_parallel(const CompiledFormula& CF, TraceView T, int threads) {
+    return truth_vectors_parallel(CF, T, threads)[CF.root][0];
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "utils.h"
+#include "compile_mltl.h"
+#include "profile.h"
+
+using namespace std;
+
+/*
+ * Truth vector of one subformula over a trace of length N.
+ * Entry t (0 <= t <= N) is the verdict of the subformula on the suffix T[t:];
+ * entry N is the verdict on the empty suffix.
+ */
+typedef vector<char> TruthVector;
+
+/*
+ * Input: compiled MLTL formula CF
+ *        trace T
+ *        profile of CF to add the time of every node to, or null
+ * Output: truth vector of every node of CF, indexed like CF.nodes,
+ *         computed bottom-up in post-order
+ */
+vector<TruthVector> truth_vectors(const CompiledFormula& CF, TraceView T, Profile* profile = nullptr);
+
+/*
+ * Truth vector of propositional variable var over trace T,
+ * false on the empty suffix
+ */
+void load_prop_var(int var, TraceView T, TruthVector& out);
+
+/*
+ * Computes the truth vector of node n from the truth vectors of its operands.
+ * left/right are null for operands n does not have.
+ * out must already hold trace_length+1 entries; only positions [from, to)
+ * are written, the others are kept, so disjoint ranges of one vector may be
+ * computed concurrently. Positions up to n.ub past to are read from the
+ * operands. n must not be a propositional variable, those are read from the
+ * trace with load_prop_var.
+ */
+void compute_truth_vector(const MLTLNode& n, size_t trace_length, const TruthVector* left,
+                          const TruthVector* right, TruthVector& out, size_t from = 0,
+                          size_t to = SIZE_MAX);
+
+/*
+ * Input: compiled MLTL formula CF
+ *        trace T
+ * Output: true if and only if CF evaluates to true on T
+ * Same verdicts as evaluate(), in time linear in |CF| * |T| plus interval work.
+ */
+bool evaluate_dp(const CompiledFormula& CF, TraceView T);
+
+/*
+ * Same as truth_vectors(), with the time axis cut into chunks that are
+ * computed on up to threads threads, for a single long trace. Nodes are
+ * computed one after the other in post-order, each in parallel chunks.
+ * A chunk of a windowed node reads its operands up to the node's upper bound
+ * past its end; those are complete by then, so the chunks overlap only in
+ * what they read and the stitched vectors are those of truth_vectors().
+ */
+vector<TruthVector> truth_vectors_parallel(const CompiledFormula& CF, TraceView T, int threads);
+
+/*
+ * evaluate_dp() on up to threads threads, see truth_vectors_parallel()
+ */
+bool evaluate_dp_parallel(const CompiledFormula& CF, TraceView T, int threads);
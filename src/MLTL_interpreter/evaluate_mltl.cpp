@@ -2,309 +2,376 @@
 #include <vector>
 #include <iostream>
 #include <stdexcept>
-#include <tuple>
-#include <algorithm>
+#include <chrono>
 #include "utils.h"
+#include "compile_mltl.h"
+#include "evaluate_mltl.h"
+#include "evaluate_dp.h"
+#include "evaluate_bits.h"
+#include "evaluate_sliced.h"
+#include "evaluate_rle.h"
 
 using namespace std;
 
-/* 
-checks if inputted string is a number
-*/
-bool digit_check(string s) {
-    for (int i = 0; i < s.length(); ++i) {
-        if (s[i] < '0' || s[i] > '9') {
-            return false;
-        }
-    }
-    return true;
-}
+/*
+ * Verdicts of every node on every suffix of one trace, filled in on demand.
+ * Suffix T[t:] of a trace of length N is position t, so a view of length
+ * L is position N - L. Node i uses bits [i * words * 64, (i+1) * words * 64)
+ * of known and value.
+ */
+struct MemoTable {
+    size_t length = 0;
+    size_t words = 0;
+    vector<uint64_t> known;
+    vector<uint64_t> value;
+};
+
+template <bool PROFILE>
+static bool compute_node(const CompiledFormula& CF, int node, TraceView T, MemoTable* memo, Profile* profile);
 
 /*
-checks if the inputted string is "p" followed by a digit
-*/
-bool prop_var_check(string s) {
-    if (s.length() < 2) {
-        return false;
-    }
-    if (s[0] != 'p') {
-        return false;
-    }
-    if (!digit_check(s.substr(1, s.length()-1))) {
-        return false;
+ * compute_node, timed into profile when PROFILE is set
+ */
+template <bool PROFILE>
+static bool timed_compute_node(const CompiledFormula& CF, int node, TraceView T, MemoTable* memo, Profile* profile) {
+    if (!PROFILE) {
+        return compute_node<PROFILE>(CF, node, T, memo, profile);
     }
-    return true;
+    // operands add their time to operand_ns, which is saved for the caller
+    double outer_ns = profile->operand_ns;
+    profile->operand_ns = 0;
+    auto start = chrono::steady_clock::now();
+    bool result = compute_node<PROFILE>(CF, node, T, memo, profile);
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    profile->nodes[node].total_ns += ns;
+    profile->nodes[node].self_ns += ns - profile->operand_ns;
+    profile->operand_ns = outer_ns + ns;
+    return result;
 }
 
-/* 
-finds ub and lb of first occurence of interval bound in formula F
-*/
-tuple<int, int> find_bounds(string F) {
-    int lbrace = F.find('[');
-    int comma = F.find(',');
-    int rbrace = F.find(']');
-    if (lbrace == string::npos || comma == string::npos || rbrace == string::npos) {
-        throw invalid_argument("Formula " + F + " is not a valid MLTL formula.");
+/*
+ Input: compiled MLTL formula CF
+        index of the node to evaluate
+        trace T
+        memo table, or null to evaluate without one
+        profile to count into, only read if PROFILE is set
+ Output: true if and only if the subformula rooted at node evaluates to true on T
+ Without PROFILE the profiling code is compiled out, so the plain evaluators
+ pay nothing for it.
+ */
+template <bool PROFILE>
+static bool evaluate_node(const CompiledFormula& CF, int node, TraceView T, MemoTable* memo, Profile* profile) {
+    if (PROFILE) {
+        ++profile->nodes[node].evaluations;
     }
-    int lb = stoi(F.substr(lbrace+1, comma-lbrace-1));
-    int ub = stoi(F.substr(comma+1, rbrace-comma-1));
-    if (lb > ub) {
-        throw invalid_argument("Formula " + F + " is not a valid MLTL formula.");
+    if (memo == nullptr) {
+        return timed_compute_node<PROFILE>(CF, node, T, nullptr, profile);
     }
-    return make_tuple(lb, ub);
+    size_t bit = node * memo->words * 64 + (memo->length - T.size());
+    if (get_bit(memo->known.data(), bit)) {
+        if (PROFILE) {
+            ++profile->nodes[node].memo_hits;
+        }
+        return get_bit(memo->value.data(), bit);
+    }
+    bool result = timed_compute_node<PROFILE>(CF, node, T, memo, profile);
+    set_bit(memo->known.data(), bit, true);
+    set_bit(memo->value.data(), bit, result);
+    return result;
 }
 
 /*
-finds index of binary connective in formula F
-*/
-int find_binary_conn(string F) {
-    int binary_conn_index = -1;
-    int pcounter = 0;
-    for (int i = 1; i < F.length()-1; ++i) {
-        if (F[i] == '(') {
-            ++pcounter;
-        } else if (F[i] == ')') {
-            --pcounter;
-        }
-        if (pcounter == 0) {
-            if (F[i] == '|' || F[i] == '&' || F[i] == '-' || F[i] == 'U' || F[i] == 'R') {
-                binary_conn_index = i; 
-                break;
-            }
-        }
+ * Counts a verdict of node decided before its whole window was read
+ */
+template <bool PROFILE>
+static void count_short_circuit(Profile* profile, int node) {
+    if (PROFILE) {
+        ++profile->nodes[node].short_circuits;
     }
-    return binary_conn_index;
 }
 
 /*
- Input: MLTL formula F
-        trace T
- Output: true if and only if F evaluates to true on F
+ * Evaluates node on T by the MLTL semantics, operands through evaluate_node
  */
-bool evaluate_mltl(string F, vector<string> T, bool verbose=false){
-    // cout << F << endl;
+template <bool PROFILE>
+static bool compute_node(const CompiledFormula& CF, int node, TraceView T, MemoTable* memo, Profile* profile) {
+    const MLTLNode& n = CF.nodes[node];
+    int lb = n.lb, ub = n.ub;
+    switch (n.op) {
 
     // Prop_cons -> true | false
-    if (F == "true") {
+    case MLTLOp::TRUE_CONS:
         return true;
-    } else if (F == "false") {
+    case MLTLOp::FALSE_CONS:
         return false;
-    }
 
     // Prop_var -> 'p' Num
-    else if (prop_var_check(F)) {
-        int p = stoi(F.substr(1, F.length()-1));
+    case MLTLOp::PROP_VAR:
         if (T.size() == 0) {
             return false;
         }
-        if (p >= T[0].length()) {
-            cout << T[0] << endl; 
-            throw invalid_argument("Propositional variable " + F + " is out of bounds of the trace.");
+        if (n.var >= T[0].length()) {
+            throw invalid_argument("Propositional variable p" + to_string(n.var) + " is out of bounds of the trace.");
         }
-        if (T[0][p] == '0') {
+        if (T[0][n.var] == '0') {
             return false;
         }
         return true;
-    }
 
     // Unary_Prop_conn -> '~' | '!'
-    else if (F[0] == '~' || F[0] == '!') {
-        return !evaluate_mltl(F.substr(1, F.length()-1), T);
-    }
+    case MLTLOp::NOT:
+        return !evaluate_node<PROFILE>(CF, n.left, T, memo, profile);
 
-    // Unary_Temp_conn -> 'F' | 'G'
-    else if ((F[0] == 'F') || (F[0] == 'G')) {
-        int lb, ub;
-        tie(lb, ub) = find_bounds(F);
-        int rbrace = F.find(']');
-        if (rbrace == string::npos) {   
-            throw invalid_argument("Formula " + F + " is not a valid MLTL formula.");
-        }
-        string subF = F.substr(rbrace+1, F.length()-rbrace-1);
-        if (verbose) {
-            cout << "lb: " << lb << endl;
-            cout << "ub: " << ub << endl;
-            cout << "subF: " << subF << endl;
-        }
-        
-        // T |- F[a, b] subF iff |T| > a and there exists i in [a, b] such that T[i:] |- subF
-        if (F[0] == 'F') {
-            if (T.size() <= lb) {
-                return false;
-            } // |T| > a
-            for (int i = lb; i <= ub; ++i) {
-                if (i >= T.size()) {
-                    break;
-                } // |T| > i
-                vector<string> subT = slice(T, i, T.size());
-                if (evaluate_mltl(subF, subT)) {
-                    return true;
+    // T |- F[a, b] subF iff |T| > a and there exists i in [a, b] such that T[i:] |- subF
+    case MLTLOp::FINALLY:
+        if (T.size() <= lb) {
+            return false;
+        } // |T| > a
+        for (int i = lb; i <= ub; ++i) {
+            if (i >= T.size()) {
+                break;
+            } // |T| > i
+            TraceView subT = T.suffix(i);
+            if (evaluate_node<PROFILE>(CF, n.left, subT, memo, profile)) {
+                if (i < ub && i < T.size() - 1) {
+                    count_short_circuit<PROFILE>(profile, node);
                 }
-            } // no i in [a, b] such that T[i:] |- subF
+                return true;
+            }
+        } // no i in [a, b] such that T[i:] |- subF
+        return false;
+
+    // T |- G[a, b] subF iff |T| <= a or for all i in [a, b], T[i:] |- subF
+    case MLTLOp::GLOBALLY:
+        if (T.size() <= lb) {
+            return true;
+        } // |T| <= a
+        for (int i = lb; i <= ub; ++i) {
+            if (i > T.size()) {
+                break;
+            } // |T| > i
+            TraceView subT = T.suffix(i);
+            if (!evaluate_node<PROFILE>(CF, n.left, subT, memo, profile)) {
+                if (i < ub && i < T.size()) {
+                    count_short_circuit<PROFILE>(profile, node);
+                }
+                return false;
+            }
+        } // for all i in [a, b], T[i:] |- subF
+        return true;
+
+    // &
+    case MLTLOp::AND:
+        if (!evaluate_node<PROFILE>(CF, n.left, T, memo, profile)) {
+            count_short_circuit<PROFILE>(profile, node);
             return false;
         }
+        return evaluate_node<PROFILE>(CF, n.right, T, memo, profile);
 
-        // T |- G[a, b] subF iff |T| <= a or for all i in [a, b], T[i:] |- subF
-        else { // F[0] == 'G'
-            if (T.size() <= lb) {
-                return true;
-            } // |T| <= a
-            for (int i = lb; i <= ub; ++i) {
-                if (i > T.size()) {
-                    break;
-                } // |T| > i
-                vector<string> subT = slice(T, i, T.size());
-                if (!evaluate_mltl(subF, subT)) {
-                    return false;
-                }
-            } // for all i in [a, b], T[i:] |- subF
+    // |
+    case MLTLOp::OR:
+        if (evaluate_node<PROFILE>(CF, n.left, T, memo, profile)) {
+            count_short_circuit<PROFILE>(profile, node);
             return true;
         }
-    }
+        return evaluate_node<PROFILE>(CF, n.right, T, memo, profile);
 
-    // find first occurence of binary connective by counting parentheses
-    else if (F[0] == '(') {
-        int binary_conn_index = find_binary_conn(F);
-        if (binary_conn_index == -1) {
-            return evaluate_mltl(F.substr(1, F.length()-2), T);
-        }
-        string subF1 = F.substr(1, binary_conn_index-1);
-        if (verbose) {
-            cout << "binary conn index: " << binary_conn_index << endl;
-            cout << "binary conn: " << F[binary_conn_index] << endl;
-            cout << "subF1: " << subF1 << endl;
-            cout << "F: " << F.substr(binary_conn_index, F.length()-binary_conn_index-1) << endl;
+    // ->
+    case MLTLOp::IMPLIES:
+        if (!evaluate_node<PROFILE>(CF, n.left, T, memo, profile)) {
+            count_short_circuit<PROFILE>(profile, node);
+            return true;
         }
-        F = F.substr(binary_conn_index, F.length()-binary_conn_index-1);
-        
-        // &
-        if (F[0] == '&') {
-            string subF2 = F.substr(1, F.length()-1);
-            if (evaluate_mltl(subF1, T) && evaluate_mltl(subF2, T)) {
-                return true;
-            }
-            return false;
-        } 
+        return evaluate_node<PROFILE>(CF, n.right, T, memo, profile);
 
-        // | 
-        else if (F[0] == '|') {
-            string subF2 = F.substr(1, F.length()-1);
-            if (evaluate_mltl(subF1, T) || evaluate_mltl(subF2, T)) {
-                return true;
+    // T |- F1 U[a,b] F2 iff |T| > a and there exists i in [a,b] such that
+    // (T[i:] |- F2 and for all j in [a, i-1], T[j:] |- F1)
+    case MLTLOp::UNTIL: {
+        if (T.size() <= lb) {
+            return false;
+        } // |T| <= a
+        // find first occurence for which T[i:] |- F2
+        int i = -1;
+        for (int k = lb; k <= ub; ++k) {
+            if (k >= T.size()) {
+                break;
+            } // |T| > j
+            TraceView subT = T.suffix(k);
+            if (evaluate_node<PROFILE>(CF, n.right, subT, memo, profile)) {
+                i = k;
+                break;
             }
+        } // no i in [a, b] such that T[i:] |- F2
+        if (i == -1) {
             return false;
         }
-
-        // ->
-        else if (F[0] == '-') {
-            if (F[1] != '>') {
-                throw invalid_argument("Formula " + F + " is not a valid MLTL formula.");
-            }
-            string subF2 = F.substr(2, F.length()-2);
-            if (evaluate_mltl(subF1, T) && !evaluate_mltl(subF2, T)) {
+        if (i < ub && i < T.size() - 1) {
+            count_short_circuit<PROFILE>(profile, node);
+        }
+        // check that for all j in [a, i-1], T[j:] |- F1
+        for (int j = lb; j < i; ++j) {
+            TraceView subT = T.suffix(j);
+            if (!evaluate_node<PROFILE>(CF, n.left, subT, memo, profile)) {
                 return false;
             }
+        } // for all j in [a, i-1], T[a:j] |- F1
+        return true;
+    }
+
+    // T |- F1 R[a,b] F2 iff |T| <= a or for all i in [a, b] T[i:] |- F2 or
+    // (there exists j in [a, b-1] such that T[j:] |- F1 and for all k in [a, j],
+    // T[k:] |- F2)
+    case MLTLOp::RELEASE: {
+        if (T.size() <= lb) {
             return true;
-        }
+        } // |T| <= a
 
-        // binary_temp_conn
-        else if (F[0] == 'U' || F[0] == 'R') {
-            int lb, ub;
-            tie(lb, ub) = find_bounds(F);
-            int rbrace = F.find(']');
-            if (rbrace == string::npos) {   
-                throw invalid_argument("Formula " + F + " is not a valid MLTL formula.");
-            }
-            string subF2 = F.substr(rbrace+1, F.length()-rbrace-1);
-            if (verbose) {
-                cout << "lb: " << lb << endl;
-                cout << "ub: " << ub << endl;
-                cout << "subF2: " << subF2 << endl;
-            }
-        
-            // T |- F1 U[a,b] F2 iff |T| > a and there exists i in [a,b] such that
-            // (T[i:] |- F2 and for all j in [a, i-1], T[j:] |- F1)
-            if (F[0] == 'U') {
-                if (T.size() <= lb) {
-                    return false;
-                } // |T| <= a
-                // find first occurence for which T[i:] |- F2
-                int i = -1; 
-                for (int k = lb; k <= ub; ++k) {
-                    if (k >= T.size()) {
-                        break;
-                    } // |T| > j
-                    vector<string> subT = slice(T, k, T.size());
-                    if (evaluate_mltl(subF2, subT)) {
-                        i = k;
-                        break;
-                    }
-                } // no i in [a, b] such that T[i:] |- F2
-                if (i == -1) {
-                    return false;
+        // check if all i in [a, b] T[i:] |- F2
+        for (int i = lb; i <= ub; ++i) {
+            TraceView subT = T.suffix(i);
+            if (!evaluate_node<PROFILE>(CF, n.right, subT, memo, profile)) {
+                if (i < ub && i < T.size() - 1) {
+                    count_short_circuit<PROFILE>(profile, node);
                 }
-                // cout << "i: " << i << endl;
-                // check that for all j in [a, i-1], T[j:] |- F1
-                for (int j = lb; j < i; ++j) {
-                    vector<string> subT = slice(T, j, T.size());
-                    if (!evaluate_mltl(subF1, subT)) {
-                        return false;
-                    }
-                    // cout << "passed at j = " << j << endl;
-                    // print(subT);
-                } // for all j in [a, i-1], T[a:j] |- F1
+                break;
+            }
+            if (i == ub || i == T.size()-1) {
                 return true;
             }
+        } // not all i in [a, b] T[i:] |- F2
 
-            // T |- F1 R[a,b] F2 iff |T| <= a or for all i in [a, b] T[i:] |- F2 or
-            // (there exists j in [a, b-1] such that T[j:] |- F1 and for all k in [a, j],
-            // T[k:] |- F2)
-            else if (F[0] == 'R') {
-                if (T.size() <= lb) {
-                    return true;
-                } // |T| <= a
-
-                // check if all i in [a, b] T[i:] |- F2
-                for (int i = lb; i <= ub; ++i) {
-                    vector<string> subT = slice(T, i, T.size());
-                    if (!evaluate_mltl(subF2, subT)) {
-                        break;
-                    }
-                    if (i == ub || i == T.size()-1) {
-                        return true;
-                    }
-                } // not all i in [a, b] T[i:] |- F2
-                
-                // find first occurence of j in [a, b-1] for which T[j:] |- F1
-                int j = -1;
-                for (int k = lb; k < ub; ++k) {
-                    vector<string> subT = slice(T, k, T.size());
-                    if (evaluate_mltl(subF1, subT) || k == T.size()-1) {
-                        j = k;
-                        break;
-                    }
-                } // no j in [a, b-1] such that T[j:] |- F1
-                if (j == -1) {
-                    return false;
-                }
-                // check that for all k in [a, j], T[k:] |- F2
-                for (int k = lb; k <= j; ++k) {
-                    vector<string> subT = slice(T, k, T.size());
-                    if (!evaluate_mltl(subF2, subT)) {
-                        return false;
-                    }
-                    if (k == T.size()-1) {
-                        break;
-                    }
-                } // for all k in [a, j], T[k:] |- F2
-                return true;
+        // find first occurence of j in [a, b-1] for which T[j:] |- F1
+        int j = -1;
+        for (int k = lb; k < ub; ++k) {
+            TraceView subT = T.suffix(k);
+            if (evaluate_node<PROFILE>(CF, n.left, subT, memo, profile) || k == T.size()-1) {
+                j = k;
+                break;
             }
+        } // no j in [a, b-1] such that T[j:] |- F1
+        if (j == -1) {
+            return false;
         }
+        // check that for all k in [a, j], T[k:] |- F2
+        for (int k = lb; k <= j; ++k) {
+            TraceView subT = T.suffix(k);
+            if (!evaluate_node<PROFILE>(CF, n.right, subT, memo, profile)) {
+                return false;
+            }
+            if (k == T.size()-1) {
+                break;
+            }
+        } // for all k in [a, j], T[k:] |- F2
+        return true;
     }
-
-    // Formula is not a valid formula
-    else {
-        throw invalid_argument("Formula " + F + " is not a valid MLTL formula.");
     }
     return false;
-}
\ No newline at end of file
+}
+
+/*
+ * Input: compiled MLTL formula CF
+ *        trace T
+ * Output: true if and only if CF evaluates to true on T
+ */
+bool evaluate(const CompiledFormula& CF, TraceView T) {
+    return evaluate_node<false>(CF, CF.root, T, nullptr, nullptr);
+}
+
+/*
+ * Input: compiled MLTL formula CF
+ *        trace T
+ * Output: true if and only if CF evaluates to true on T
+ */
+bool evaluate_memo(const CompiledFormula& CF, TraceView T) {
+    MemoTable memo;
+    memo.length = T.size();
+    memo.words = words_for(T.size());
+    memo.known.assign(CF.nodes.size() * memo.words, 0);
+    memo.value.assign(CF.nodes.size() * memo.words, 0);
+    return evaluate_node<false>(CF, CF.root, T, &memo, nullptr);
+}
+
+/*
+ * Maps a command line flag to the engine it selects.
+ * Returns false if flag does not name an engine.
+ */
+bool parse_engine_flag(const string& flag, Engine& engine) {
+    if (flag == "-dp") {
+        engine = Engine::DP;
+    } else if (flag == "-bits") {
+        engine = Engine::BITS;
+    } else if (flag == "-memo") {
+        engine = Engine::MEMO;
+    } else if (flag == "-sliced") {
+        engine = Engine::SLICED;
+    } else if (flag == "-rle") {
+        engine = Engine::RLE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Input: compiled MLTL formula CF
+ *        trace T
+ *        engine to evaluate with
+ * Output: true if and only if CF evaluates to true on T
+ */
+bool evaluate(const CompiledFormula& CF, TraceView T, Engine engine) {
+    switch (engine) {
+    case Engine::MEMO:
+        return evaluate_memo(CF, T);
+    case Engine::DP:
+        return evaluate_dp(CF, T);
+    case Engine::BITS:
+        return evaluate_bits(CF, pack_trace(T));
+    case Engine::SLICED:
+        return evaluate_sliced(CF, slice_batch({T}))[0];
+    case Engine::RLE:
+        return evaluate_rle(CF, encode_rle(T));
+    default:
+        return evaluate(CF, T);
+    }
+}
+
+/*
+ * Input: compiled MLTL formula CF
+ *        trace T
+ *        engine to evaluate with: the default, MEMO or DP
+ *        profile of CF to count into
+ * Output: true if and only if CF evaluates to true on T
+ */
+bool evaluate_profiled(const CompiledFormula& CF, TraceView T, Engine engine, Profile& profile) {
+    switch (engine) {
+    case Engine::RECURSIVE:
+        return evaluate_node<true>(CF, CF.root, T, nullptr, &profile);
+    case Engine::MEMO: {
+        MemoTable memo;
+        memo.length = T.size();
+        memo.words = words_for(T.size());
+        memo.known.assign(CF.nodes.size() * memo.words, 0);
+        memo.value.assign(CF.nodes.size() * memo.words, 0);
+        profile.memo = true;
+        return evaluate_node<true>(CF, CF.root, T, &memo, &profile);
+    }
+    case Engine::DP:
+        profile.top_down = false;
+        return truth_vectors(CF, T, &profile)[CF.root][0];
+    default:
+        throw invalid_argument("Profiling supports the default, -memo and -dp engines.");
+    }
+}
+
+/*
+ Input: MLTL formula F
+        trace T
+ Output: true if and only if F evaluates to true on F
+ */
+bool evaluate_mltl(string F, vector<string> T, bool verbose){
+    CompiledFormula CF = compile_mltl(F);
+    if (verbose) {
+        cout << "compiled: " << formula_to_string(CF) << endl;
+    }
+    return evaluate(CF, T);
+}
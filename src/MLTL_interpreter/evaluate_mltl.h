@@ -2,12 +2,71 @@
 #include <string>
 #include <vector>
 #include "utils.h"
+#include "compile_mltl.h"
+#include "profile.h"
 
 using namespace std;
 
+/*
+ * Input: compiled MLTL formula CF
+ *        view T of a trace, a plain vector<string> converts implicitly
+ * Output: true if and only if CF evaluates to true on T
+ * Suffixes are taken as views into T, so evaluation copies no timesteps.
+ */
+bool evaluate(const CompiledFormula& CF, TraceView T);
+
+/*
+ * Input: compiled MLTL formula CF
+ *        trace T
+ * Output: true if and only if CF evaluates to true on T
+ * Same top-down recursion and short-circuiting as evaluate(), but every
+ * (node, suffix) verdict is kept in a bitmap per node, so no subformula is
+ * evaluated twice on the same suffix. Costs 2 bits per node per timestep.
+ */
+bool evaluate_memo(const CompiledFormula& CF, TraceView T);
+
+/*
+ * Evaluation engines selectable from the command line
+ */
+enum class Engine {
+    RECURSIVE, // top-down recursion over suffixes (default)
+    MEMO,      // top-down recursion, memoized per (node, suffix)
+    DP,        // bottom-up truth vectors, evaluate_dp.h
+    BITS,      // bottom-up bit-packed vectors, evaluate_bits.h
+    SLICED,    // many traces per pass, one per bit lane, evaluate_sliced.h
+    RLE,       // bottom-up over run-length encoded segments, evaluate_rle.h
+};
+
+/*
+ * Maps a command line flag to the engine it selects.
+ * Returns false if flag does not name an engine.
+ */
+bool parse_engine_flag(const string& flag, Engine& engine);
+
+/*
+ * Input: compiled MLTL formula CF
+ *        trace T
+ *        engine to evaluate with
+ * Output: true if and only if CF evaluates to true on T
+ */
+bool evaluate(const CompiledFormula& CF, TraceView T, Engine engine);
+
+/*
+ * Input: compiled MLTL formula CF
+ *        trace T
+ *        engine to evaluate with: the default, MEMO or DP
+ *        profile of CF to count into
+ * Output: true if and only if CF evaluates to true on T
+ * The top-down engines count every (node, suffix) verdict asked for, DP
+ * counts the positions of every truth vector.
+ * Throws invalid_argument for the other engines.
+ */
+bool evaluate_profiled(const CompiledFormula& CF, TraceView T, Engine engine, Profile& profile);
+
 /*
  * Input: MLTL formula F
  *        trace T
  * Output: true if and only if F evaluates to true on F
+ * Compiles F on every call, prefer compile_mltl + evaluate when F is reused.
  */
-bool evaluate_mltl(string F, vector<string> T, bool verbose=false);
\ No newline at end of file
+bool evaluate_mltl(string F, vector<string> T, bool verbose=false);
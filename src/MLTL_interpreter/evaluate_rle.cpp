@@ -0,0 +1,286 @@
+#include <algorithm>
+#include <stdexcept>
+#include "evaluate_rle.h"
+
+using namespace std;
+
+const size_t NONE = (size_t) -1;
+
+/*
+ * Appends [b, e) to L, merging it with the last interval when they touch.
+ * Intervals must be appended in order of b.
+ */
+static void append(IntervalList& L, size_t b, size_t e) {
+    if (b >= e) {
+        return;
+    }
+    if (!L.empty() && b <= L.back().second) {
+        L.back().second = max(L.back().second, e);
+    } else {
+        L.push_back({b, e});
+    }
+}
+
+RLETrace encode_rle(TraceView T) {
+    RLETrace R;
+    R.length = T.size();
+    size_t num_vars = 0;
+    for (size_t t = 0; t < T.size(); ++t) {
+        num_vars = (t == 0) ? T[t].length() : min(num_vars, T[t].length());
+    }
+    R.vars.resize(num_vars);
+    for (size_t p = 0; p < num_vars; ++p) {
+        for (size_t t = 0; t < T.size(); ++t) {
+            if (T[t][p] != '0') {
+                append(R.vars[p], t, t + 1);
+            }
+        }
+    }
+    return R;
+}
+
+/*
+ * Positions of [lo, hi) not covered by L
+ */
+static IntervalList complement(const IntervalList& L, size_t lo, size_t hi) {
+    IntervalList out;
+    size_t from = lo;
+    for (const auto& iv : L) {
+        append(out, from, min(iv.first, hi));
+        from = max(from, iv.second);
+    }
+    append(out, from, hi);
+    return out;
+}
+
+static IntervalList clip(const IntervalList& L, size_t lo, size_t hi) {
+    IntervalList out;
+    for (const auto& iv : L) {
+        append(out, max(iv.first, lo), min(iv.second, hi));
+    }
+    return out;
+}
+
+static IntervalList unite(const IntervalList& A, const IntervalList& B) {
+    IntervalList out;
+    size_t i = 0, j = 0;
+    while (i < A.size() || j < B.size()) {
+        if (j == B.size() || (i < A.size() && A[i].first <= B[j].first)) {
+            append(out, A[i].first, A[i].second);
+            ++i;
+        } else {
+            append(out, B[j].first, B[j].second);
+            ++j;
+        }
+    }
+    return out;
+}
+
+static IntervalList intersect(const IntervalList& A, const IntervalList& B) {
+    IntervalList out;
+    size_t i = 0, j = 0;
+    while (i < A.size() && j < B.size()) {
+        append(out, max(A[i].first, B[j].first), min(A[i].second, B[j].second));
+        if (A[i].second < B[j].second) {
+            ++i;
+        } else {
+            ++j;
+        }
+    }
+    return out;
+}
+
+/*
+ * A maximal segment of [0, N) on which both operands are constant
+ */
+struct Segment {
+    size_t begin, end;
+    bool left, right;
+};
+
+static vector<Segment> segments(const IntervalList& L, const IntervalList& R, size_t N) {
+    vector<size_t> cuts = {0, N};
+    for (const IntervalList* X : {&L, &R}) {
+        for (const auto& iv : *X) {
+            cuts.push_back(min(iv.first, N));
+            cuts.push_back(min(iv.second, N));
+        }
+    }
+    sort(cuts.begin(), cuts.end());
+    cuts.erase(unique(cuts.begin(), cuts.end()), cuts.end());
+    vector<Segment> out;
+    size_t i = 0, j = 0;
+    for (size_t c = 0; c + 1 < cuts.size(); ++c) {
+        size_t b = cuts[c];
+        while (i < L.size() && L[i].second <= b) {
+            ++i;
+        }
+        while (j < R.size() && R[j].second <= b) {
+            ++j;
+        }
+        bool l = i < L.size() && L[i].first <= b;
+        bool r = j < R.size() && R[j].first <= b;
+        out.push_back({b, cuts[c+1], l, r});
+    }
+    return out;
+}
+
+/*
+ * Shifts every interval down by a, dropping what falls below 0
+ */
+static IntervalList shift_down(const IntervalList& L, size_t a) {
+    IntervalList out;
+    for (const auto& iv : L) {
+        if (iv.second > a) {
+            append(out, (iv.first > a) ? iv.first - a : 0, iv.second - a);
+        }
+    }
+    return out;
+}
+
+/*
+ * Computes the interval list of node n from those of its operands.
+ * All lists cover positions [0, N]; position N is the empty suffix.
+ */
+static void compute_interval_list(const MLTLNode& n, const RLETrace& R, const IntervalList* left,
+                                  const IntervalList* right, IntervalList& out) {
+    const size_t N = R.length;
+    const size_t a = n.lb, b = n.ub, w = b - a + 1;
+    out.clear();
+    switch (n.op) {
+    case MLTLOp::TRUE_CONS:
+        append(out, 0, N + 1);
+        break;
+    case MLTLOp::FALSE_CONS:
+        break;
+
+    // false on the empty suffix
+    case MLTLOp::PROP_VAR:
+        if (n.var >= R.vars.size()) {
+            if (N == 0) {
+                break;
+            }
+            throw invalid_argument("Propositional variable p" + to_string(n.var) + " is out of bounds of the trace.");
+        }
+        out = R.vars[n.var];
+        break;
+
+    case MLTLOp::NOT:
+        out = complement(*left, 0, N + 1);
+        break;
+    case MLTLOp::AND:
+        out = intersect(*left, *right);
+        break;
+    case MLTLOp::OR:
+        out = unite(*left, *right);
+        break;
+    case MLTLOp::IMPLIES:
+        out = unite(complement(*left, 0, N + 1), *right);
+        break;
+
+    // subF true on [s, e) makes F true for t in [s-b, e-1-a]
+    case MLTLOp::FINALLY:
+        for (const auto& iv : clip(*left, 0, N)) {
+            append(out, (iv.first > b) ? iv.first - b : 0, (iv.second > a) ? iv.second - a : 0);
+        }
+        break;
+
+    // subF false on [s, e), the empty suffix included, makes G false for
+    // t in [s-b, e-1-a] with t+a < N
+    case MLTLOp::GLOBALLY: {
+        IntervalList bad;
+        size_t limit = (N > a) ? N - a : 0;
+        for (const auto& iv : complement(*left, 0, N + 1)) {
+            append(bad, (iv.first > b) ? iv.first - b : 0, min((iv.second > a) ? iv.second - a : 0, limit));
+        }
+        out = complement(bad, 0, N + 1);
+        break;
+    }
+
+    // sweep the segments right to left, tracking the next F2 and the next
+    // !F1; from s = t+a, the first F2 must come within w steps and before
+    // any !F1
+    case MLTLOp::UNTIL: {
+        vector<Segment> segs = segments(*left, *right, N);
+        IntervalList good;
+        size_t next_f2 = NONE, next_not_f1 = NONE;
+        for (size_t k = segs.size(); k-- > 0;) {
+            const Segment& g = segs[k];
+            if (g.right) {
+                good.push_back({g.begin, g.end});
+                next_f2 = g.begin;
+            } else if (g.left && next_f2 != NONE && next_not_f1 >= next_f2) {
+                size_t from = (next_f2 + 1 > w) ? next_f2 + 1 - w : 0;
+                if (max(g.begin, from) < g.end) {
+                    good.push_back({max(g.begin, from), g.end});
+                }
+            }
+            if (!g.left) {
+                next_not_f1 = g.begin;
+            }
+        }
+        reverse(good.begin(), good.end());
+        IntervalList merged;
+        for (const auto& iv : good) {
+            append(merged, iv.first, iv.second);
+        }
+        out = shift_down(merged, a);
+        break;
+    }
+
+    // |T[t:]| <= a is true; otherwise from s = t+a the first !F2 must lie
+    // past the window (or the trace), or come after an F1
+    case MLTLOp::RELEASE: {
+        vector<Segment> segs = segments(*left, *right, N);
+        IntervalList good;
+        size_t next_not_f2 = NONE, next_f1 = NONE;
+        for (size_t k = segs.size(); k-- > 0;) {
+            const Segment& g = segs[k];
+            if (g.right && g.left) {
+                good.push_back({g.begin, g.end});
+            } else if (g.right) {
+                if (next_not_f2 == NONE || (next_f1 != NONE && next_f1 < next_not_f2)) {
+                    good.push_back({g.begin, g.end});
+                } else {
+                    size_t until = (next_not_f2 + 1 > w) ? next_not_f2 + 1 - w : 0;
+                    if (g.begin < min(g.end, until)) {
+                        good.push_back({g.begin, min(g.end, until)});
+                    }
+                }
+            }
+            if (!g.right) {
+                next_not_f2 = g.begin;
+            }
+            if (g.left) {
+                next_f1 = g.begin;
+            }
+        }
+        reverse(good.begin(), good.end());
+        IntervalList merged;
+        for (const auto& iv : good) {
+            append(merged, iv.first, iv.second);
+        }
+        // good positions all lie below N - a, so the short suffixes come last
+        out = shift_down(merged, a);
+        append(out, (N > a) ? N - a : 0, N + 1);
+        break;
+    }
+    }
+}
+
+vector<IntervalList> interval_lists(const CompiledFormula& CF, const RLETrace& R) {
+    vector<IntervalList> lists(CF.nodes.size());
+    for (int i = 0; i < CF.nodes.size(); ++i) {
+        const MLTLNode& n = CF.nodes[i];
+        const IntervalList* left = (n.left == -1) ? nullptr : &lists[n.left];
+        const IntervalList* right = (n.right == -1) ? nullptr : &lists[n.right];
+        compute_interval_list(n, R, left, right, lists[i]);
+    }
+    return lists;
+}
+
+bool evaluate_rle(const CompiledFormula& CF, const RLETrace& R) {
+    vector<IntervalList> lists = interval_lists(CF, R);
+    const IntervalList& root = lists[CF.root];
+    return !root.empty() && root[0].first == 0;
+}
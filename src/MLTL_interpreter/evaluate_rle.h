@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "utils.h"
+#include "compile_mltl.h"
+
+using namespace std;
+
+/*
+ * The positions where a signal is true, as sorted, disjoint and
+ * non-adjacent half-open intervals [begin, end)
+ */
+typedef vector<pair<size_t, size_t>> IntervalList;
+
+/*
+ * Run-length encoded trace: each propositional variable is the list of
+ * segments where it is true, so its size is the number of changes.
+ */
+struct RLETrace {
+    size_t length = 0;        // number of timesteps
+    vector<IntervalList> vars;
+};
+
+/*
+ * Run-length encodes trace T.
+ * The number of variables is the width of the narrowest timestep.
+ */
+RLETrace encode_rle(TraceView T);
+
+/*
+ * Input: compiled MLTL formula CF
+ *        run-length encoded trace R
+ * Output: interval list of every node of CF over positions [0, R.length],
+ *         indexed like CF.nodes (same meaning as truth_vectors)
+ * Every operator works on whole segments, so the cost grows with the
+ * number of signal changes rather than with the trace length.
+ */
+vector<IntervalList> interval_lists(const CompiledFormula& CF, const RLETrace& R);
+
+/*
+ * Input: compiled MLTL formula CF
+ *        run-length encoded trace R
+ * Output: true if and only if CF evaluates to true on R
+ */
+bool evaluate_rle(const CompiledFormula& CF, const RLETrace& R);
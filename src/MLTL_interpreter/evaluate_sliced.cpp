@@ -0,0 +1,261 @@
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+#include "evaluate_sliced.h"
+#include "packed_trace.h"
+#include "work_pool.h"
+
+using namespace std;
+
+/*
+ * A vector of lane words over positions [0, length], one word per position
+ */
+typedef vector<uint64_t> LaneVector;
+
+const uint64_t ALL_LANES = ~uint64_t(0);
+
+/*
+ * Transposes traces (at most SLICE_LANES of them) into a SlicedBatch
+ */
+SlicedBatch slice_batch(const vector<TraceView>& traces) {
+    if (traces.size() > SLICE_LANES) {
+        throw invalid_argument("A sliced batch holds at most " + to_string(SLICE_LANES) + " traces.");
+    }
+    SlicedBatch B;
+    B.lanes = traces.size();
+    bool first = true;
+    for (const TraceView& T : traces) {
+        B.length = max(B.length, T.size());
+        for (size_t t = 0; t < T.size(); ++t) {
+            B.num_vars = first ? T[t].length() : min(B.num_vars, T[t].length());
+            first = false;
+        }
+    }
+    const size_t S = B.length + 1;
+    B.vars.assign(B.num_vars * S, 0);
+    B.live.assign(S, 0);
+    for (size_t l = 0; l < traces.size(); ++l) {
+        const uint64_t lane = uint64_t(1) << l;
+        const TraceView& T = traces[l];
+        for (size_t t = 0; t < T.size(); ++t) {
+            B.live[t] |= lane;
+            for (size_t p = 0; p < B.num_vars; ++p) {
+                if (T[t][p] != '0') {
+                    B.vars[p * S + t] |= lane;
+                }
+            }
+        }
+    }
+    return B;
+}
+
+/*
+ * out[u] = v[u + k], or pad once u + k runs past the end
+ */
+static LaneVector shift_down(const LaneVector& v, size_t k, uint64_t pad) {
+    LaneVector out(v.size(), pad);
+    if (k < v.size()) {
+        copy(v.begin() + k, v.end(), out.begin());
+    }
+    return out;
+}
+
+/*
+ * out[u] = AND of C[u .. u+w-1], positions past the end count as true.
+ * Built by window doubling in O(|C| log w) word operations.
+ */
+static LaneVector window_and(const LaneVector& C, size_t w) {
+    const size_t S = C.size();
+    LaneVector out = C;
+    size_t len = 1;
+    while (len < w && len < S) {
+        size_t step = min(len, w - len);
+        LaneVector shifted = shift_down(out, step, ALL_LANES);
+        bits_and(out.data(), shifted.data(), out.data(), S);
+        len += step;
+    }
+    return out;
+}
+
+/*
+ * out[u] = there is an s in [u, u+w-1] with A[s] and C[u .. s-1] all true.
+ * Positions past the end count as A false, C true.
+ * Windows of power-of-two width are doubled,
+ *   W_2p(u) = W_p(u) | (C_p(u) & W_p(u+p)),   C_2p(u) = C_p(u) & C_p(u+p),
+ * and the ones selected by the binary digits of w are chained one after
+ * another, so the whole window costs O(|A| log w) word operations.
+ */
+static LaneVector window_until(const LaneVector& A, const LaneVector& C, size_t w) {
+    const size_t S = A.size();
+    LaneVector Wp = A, Cp = C;
+    LaneVector acc_W(S, 0), acc_C(S, ALL_LANES), tmp(S);
+    size_t x = 0; // width already chained into acc
+    for (size_t p = 1; p <= w; p *= 2) {
+        if (w & p) {
+            // acc covers [u, u+x-1], append the segment [u+x, u+x+p-1]
+            LaneVector W_shift = shift_down(Wp, x, 0);
+            bits_and(acc_C.data(), W_shift.data(), tmp.data(), S);
+            bits_or(acc_W.data(), tmp.data(), acc_W.data(), S);
+            LaneVector C_shift = shift_down(Cp, x, ALL_LANES);
+            bits_and(acc_C.data(), C_shift.data(), acc_C.data(), S);
+            x += p;
+        }
+        if (p > w / 2 || x >= S) {
+            break;
+        }
+        LaneVector W_next = shift_down(Wp, p, 0);
+        bits_and(Cp.data(), W_next.data(), tmp.data(), S);
+        bits_or(Wp.data(), tmp.data(), Wp.data(), S);
+        LaneVector C_next = shift_down(Cp, p, ALL_LANES);
+        bits_and(Cp.data(), C_next.data(), Cp.data(), S);
+    }
+    return acc_W;
+}
+
+/*
+ * Computes the lane vector of node n from the lane vectors of its operands
+ */
+static void compute_lane_vector(const MLTLNode& n, const SlicedBatch& B, const LaneVector* left,
+                                const LaneVector* right, LaneVector& out) {
+    const size_t S = B.length + 1;
+    const size_t lb = n.lb, w = n.ub - n.lb + 1;
+    LaneVector not_live(S);
+    bits_not(B.live.data(), not_live.data(), S);
+    out.assign(S, 0);
+    switch (n.op) {
+    case MLTLOp::TRUE_CONS:
+        fill(out.begin(), out.end(), ALL_LANES);
+        break;
+    case MLTLOp::FALSE_CONS:
+        break;
+
+    // zero past the end of each trace, so false on the empty suffix
+    case MLTLOp::PROP_VAR:
+        if (n.var >= B.num_vars) {
+            if (B.length == 0) {
+                break;
+            }
+            throw invalid_argument("Propositional variable p" + to_string(n.var) + " is out of bounds of the trace.");
+        }
+        copy(B.vars.begin() + n.var * S, B.vars.begin() + (n.var + 1) * S, out.begin());
+        break;
+
+    case MLTLOp::NOT:
+        bits_not(left->data(), out.data(), S);
+        break;
+    case MLTLOp::AND:
+        bits_and(left->data(), right->data(), out.data(), S);
+        break;
+    case MLTLOp::OR:
+        bits_or(left->data(), right->data(), out.data(), S);
+        break;
+    case MLTLOp::IMPLIES:
+        bits_andnot(left->data(), right->data(), out.data(), S);
+        bits_not(out.data(), out.data(), S);
+        break;
+
+    // exists i in [a, b] with subF at t+i, counting only live positions
+    case MLTLOp::FINALLY: {
+        LaneVector A(S), ones(S, ALL_LANES);
+        bits_and(left->data(), B.live.data(), A.data(), S);
+        out = shift_down(window_until(A, ones, w), lb, 0);
+        break;
+    }
+
+    // |T[t:]| <= a, or subF at every t+i for i in [a, b] up to the empty
+    // suffix: positions past the end of a trace count as true
+    case MLTLOp::GLOBALLY: {
+        // the empty suffix itself is still evaluated: it is not live, but
+        // it is reached when the previous position was live
+        LaneVector sub(S);
+        for (size_t t = 0; t < S; ++t) {
+            uint64_t reached = (t == 0) ? ALL_LANES : B.live[t-1];
+            sub[t] = (*left)[t] | ~reached;
+        }
+        LaneVector window = shift_down(window_and(sub, w), lb, ALL_LANES);
+        LaneVector short_trace = shift_down(not_live, lb, ALL_LANES);
+        bits_or(window.data(), short_trace.data(), out.data(), S);
+        break;
+    }
+
+    // the first F2 in the window at a live position, with F1 before it
+    case MLTLOp::UNTIL: {
+        LaneVector A(S);
+        bits_and(right->data(), B.live.data(), A.data(), S);
+        out = shift_down(window_until(A, *left, w), lb, 0);
+        break;
+    }
+
+    // |T[t:]| <= a, or F2 on the whole live part of the window, or some
+    // F1 in [a, b-1] with F2 up to and including it
+    case MLTLOp::RELEASE: {
+        LaneVector F2(S), A(S);
+        bits_or(right->data(), not_live.data(), F2.data(), S);
+        bits_and(left->data(), B.live.data(), A.data(), S);
+        bits_and(A.data(), F2.data(), A.data(), S);
+        LaneVector holds = window_and(F2, w);
+        if (w > 1) {
+            LaneVector released = window_until(A, F2, w - 1);
+            bits_or(holds.data(), released.data(), holds.data(), S);
+        }
+        LaneVector window = shift_down(holds, lb, ALL_LANES);
+        LaneVector short_trace = shift_down(not_live, lb, ALL_LANES);
+        bits_or(window.data(), short_trace.data(), out.data(), S);
+        break;
+    }
+    }
+}
+
+/*
+ * Input: compiled MLTL formula CF
+ *        batch of traces B
+ * Output: the verdict of CF on every trace of B, in lane order.
+ */
+vector<bool> evaluate_sliced(const CompiledFormula& CF, const SlicedBatch& B) {
+    vector<LaneVector> vectors(CF.nodes.size());
+    for (int i = 0; i < CF.nodes.size(); ++i) {
+        const MLTLNode& n = CF.nodes[i];
+        const LaneVector* left = (n.left == -1) ? nullptr : &vectors[n.left];
+        const LaneVector* right = (n.right == -1) ? nullptr : &vectors[n.right];
+        compute_lane_vector(n, B, left, right, vectors[i]);
+    }
+    vector<bool> verdicts(B.lanes);
+    for (size_t l = 0; l < B.lanes; ++l) {
+        verdicts[l] = (vectors[CF.root][0] >> l) & 1;
+    }
+    return verdicts;
+}
+
+/*
+ * Input: compiled MLTL formula CF
+ *        any number of traces
+ *        number of worker threads
+ * Output: the verdict of CF on every trace, in input order.
+ * Traces are grouped by similar length into batches of SLICE_LANES.
+ */
+vector<bool> evaluate_sliced(const CompiledFormula& CF, const vector<TraceView>& traces, int threads) {
+    // longest traces first, so the most expensive batches are started first
+    vector<size_t> order(traces.size());
+    iota(order.begin(), order.end(), 0);
+    stable_sort(order.begin(), order.end(), [&](size_t i, size_t j) {
+        return traces[i].size() > traces[j].size();
+    });
+    size_t groups = (order.size() + SLICE_LANES - 1) / SLICE_LANES;
+    vector<vector<bool>> group_verdicts(groups);
+    parallel_for(groups, threads, [&](size_t g) {
+        size_t begin = g * SLICE_LANES;
+        size_t end = min(order.size(), begin + SLICE_LANES);
+        vector<TraceView> group;
+        for (size_t k = begin; k < end; ++k) {
+            group.push_back(traces[order[k]]);
+        }
+        group_verdicts[g] = evaluate_sliced(CF, slice_batch(group));
+    });
+    vector<bool> verdicts(traces.size());
+    for (size_t k = 0; k < order.size(); ++k) {
+        verdicts[order[k]] = group_verdicts[k / SLICE_LANES][k % SLICE_LANES];
+    }
+    return verdicts;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "utils.h"
+#include "compile_mltl.h"
+
+using namespace std;
+
+/*
+ * Maximum number of traces evaluated together, one per bit of a word
+ */
+const size_t SLICE_LANES = 64;
+
+/*
+ * Up to SLICE_LANES traces transposed so that bit l of every word belongs
+ * to trace l. Word t of a vector holds position t of every trace.
+ * Traces may have different lengths: live[t] has bit l set iff trace l has
+ * more than t timesteps, so positions past a trace's end can be masked out.
+ */
+struct SlicedBatch {
+    size_t lanes = 0;      // number of traces
+    size_t length = 0;     // length of the longest trace
+    size_t num_vars = 0;   // variables available in every non-empty trace
+    vector<uint64_t> vars; // vars[p * (length+1) + t], 0 past each trace's end
+    vector<uint64_t> live; // live[t] for t in [0, length]
+};
+
+/*
+ * Transposes traces (at most SLICE_LANES of them) into a SlicedBatch
+ */
+SlicedBatch slice_batch(const vector<TraceView>& traces);
+
+/*
+ * Input: compiled MLTL formula CF
+ *        batch of traces B
+ * Output: the verdict of CF on every trace of B, in lane order.
+ * One pass over CF evaluates all lanes; each node costs
+ * O(|B.length| * log(ub-lb+1)) word operations for the whole batch.
+ */
+vector<bool> evaluate_sliced(const CompiledFormula& CF, const SlicedBatch& B);
+
+/*
+ * Input: compiled MLTL formula CF
+ *        any number of traces
+ *        number of worker threads
+ * Output: the verdict of CF on every trace, in input order.
+ * Traces are grouped by similar length into batches of SLICE_LANES,
+ * which are spread over the worker threads.
+ */
+vector<bool> evaluate_sliced(const CompiledFormula& CF, const vector<TraceView>& traces, int threads = 1);
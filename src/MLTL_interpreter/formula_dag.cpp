@@ -0,0 +1,75 @@
+#include <map>
+#include <tuple>
+#include "formula_dag.h"
+#include "evaluate_dp.h"
+#include "work_pool.h"
+
+using namespace std;
+
+typedef tuple<MLTLOp, int, int, int, int, int> NodeKey;
+
+FormulaDAG build_dag(const vector<CompiledFormula>& formulas) {
+    FormulaDAG D;
+    map<NodeKey, int> index;
+    for (const CompiledFormula& CF : formulas) {
+        // node i of CF becomes node ids[i] of D, operands come first
+        vector<int> ids(CF.nodes.size());
+        for (int i = 0; i < CF.nodes.size(); ++i) {
+            MLTLNode n = CF.nodes[i];
+            if (n.left != -1) {
+                n.left = ids[n.left];
+            }
+            if (n.right != -1) {
+                n.right = ids[n.right];
+            }
+            if ((n.op == MLTLOp::AND || n.op == MLTLOp::OR) && n.right < n.left) {
+                swap(n.left, n.right);
+            }
+            NodeKey key(n.op, n.var, n.lb, n.ub, n.left, n.right);
+            auto it = index.find(key);
+            if (it == index.end()) {
+                it = index.emplace(key, D.nodes.size()).first;
+                D.nodes.push_back(n);
+            }
+            ids[i] = it->second;
+        }
+        D.roots.push_back(ids[CF.root]);
+        D.input_nodes += CF.nodes.size();
+    }
+    return D;
+}
+
+vector<bool> evaluate_dag(const FormulaDAG& D, TraceView T) {
+    vector<TruthVector> vectors(D.nodes.size());
+    for (int i = 0; i < D.nodes.size(); ++i) {
+        const MLTLNode& n = D.nodes[i];
+        if (n.op == MLTLOp::PROP_VAR) {
+            load_prop_var(n.var, T, vectors[i]);
+            continue;
+        }
+        const TruthVector* left = (n.left == -1) ? nullptr : &vectors[n.left];
+        const TruthVector* right = (n.right == -1) ? nullptr : &vectors[n.right];
+        vectors[i].assign(T.size()+1, 0);
+        compute_truth_vector(n, T.size(), left, right, vectors[i]);
+    }
+    vector<bool> verdicts(D.roots.size());
+    for (size_t f = 0; f < D.roots.size(); ++f) {
+        verdicts[f] = vectors[D.roots[f]][0];
+    }
+    return verdicts;
+}
+
+vector<vector<bool>> evaluate_dag(const FormulaDAG& D, const vector<TraceView>& traces, int threads) {
+    // one task per trace, each fills its own column
+    vector<vector<bool>> columns(traces.size());
+    parallel_for(traces.size(), threads, [&](size_t t) {
+        columns[t] = evaluate_dag(D, traces[t]);
+    });
+    vector<vector<bool>> matrix(D.roots.size(), vector<bool>(traces.size()));
+    for (size_t t = 0; t < traces.size(); ++t) {
+        for (size_t f = 0; f < D.roots.size(); ++f) {
+            matrix[f][t] = columns[t][f];
+        }
+    }
+    return matrix;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <vector>
+#include "utils.h"
+#include "compile_mltl.h"
+
+using namespace std;
+
+/*
+ * Several compiled formulas merged into one DAG: structurally equal
+ * subformulas (up to the order of the operands of & and |) are stored once.
+ * Like CompiledFormula, operands always precede the nodes that use them.
+ */
+struct FormulaDAG {
+    vector<MLTLNode> nodes;
+    vector<int> roots;      // root node of each formula, in input order
+    size_t input_nodes = 0; // total size of the formulas before merging
+};
+
+/*
+ * Input: compiled formulas
+ * Output: the formulas hash-consed into a single FormulaDAG
+ */
+FormulaDAG build_dag(const vector<CompiledFormula>& formulas);
+
+/*
+ * Input: formula DAG D
+ *        trace T
+ * Output: the verdict of every formula of D on T, in input order.
+ * Every distinct subformula is evaluated once with the DP kernels.
+ */
+vector<bool> evaluate_dag(const FormulaDAG& D, TraceView T);
+
+/*
+ * Input: formula DAG D
+ *        traces
+ *        number of worker threads
+ * Output: verdict matrix, entry [f][t] is the verdict of formula f on trace t
+ */
+vector<vector<bool>> evaluate_dag(const FormulaDAG& D, const vector<TraceView>& traces, int threads = 1);
@@ -2,25 +2,129 @@
 #include <vector>
 #include <string>
 #include <fstream>
+#include <algorithm>
+#include <cctype>
 #include "utils.h"
 #include "evaluate_mltl.h"
+#include "stream_monitor.h"
+#include "serve.h"
+#include "simplify.h"
+#include "evaluate_dp.h"
+#include "work_pool.h"
+#include "signal_store.h"
 
 using namespace std;
 
+/*
+ * interpret --stream [formula file]
+ * Reads timesteps from stdin, one per line, and writes "t : verdict" to
+ * stdout for every position t as soon as its verdict is decided.
+ */
+static int stream(const string& formula_file) {
+    vector<string> formula_vec = read_from_file(formula_file);
+    if (formula_vec.size() == 0) {
+        throw invalid_argument("Formula file is empty.");
+    }
+    string formula = formula_vec[0];
+    for (int i = 1; i < formula_vec.size(); ++i) {
+        formula = "(" + formula + "&" + formula_vec[i] + ")";
+    }
+    formula = strip_char(formula, ' ');
+    // the monitor keeps values per parent, so subformulas are not shared
+    CompiledFormula compiled = simplify(compile_mltl(formula), false);
+    // rows arrive on stdin without column names
+    check_no_signals(compiled);
+    StreamMonitor monitor(compiled);
+
+    vector<bool> verdicts;
+    size_t written = 0;
+    string row;
+    while (getline(cin, row)) {
+        if (row.empty()) {
+            continue;
+        }
+        monitor.push(row, verdicts);
+        for (; written < verdicts.size(); ++written) {
+            cout << written << " : " << verdicts[written] << endl;
+        }
+    }
+    monitor.finish(verdicts);
+    for (; written < verdicts.size(); ++written) {
+        cout << written << " : " << verdicts[written] << endl;
+    }
+    return 0;
+}
+
 int main(int argc, char** argv) {
-    // should be 4 arguments: formula file, trace file, output file, and optional flag for printing
-    if (argc != 4 && argc != 5) {
+    if (argc >= 2 && string(argv[1]) == "--stream") {
+        if (argc != 3) {
+            throw invalid_argument("Incorrect number of arguments.");
+        }
+        return stream(argv[2]);
+    }
+
+    // interpret --serve [socket path] [engine flag]
+    // answers requests on stdin/stdout, or on a UNIX socket if a path is given
+    if (argc >= 2 && string(argv[1]) == "--serve") {
+        string socket_path;
+        Engine engine = Engine::RECURSIVE;
+        for (int i = 2; i < argc; ++i) {
+            string arg = argv[i];
+            if (!parse_engine_flag(arg, engine)) {
+                if (!socket_path.empty() || arg[0] == '-') {
+                    throw invalid_argument("Incorrect flag.");
+                }
+                socket_path = arg;
+            }
+        }
+        if (socket_path.empty()) {
+            FormulaCache cache;
+            serve_stream(0, 1, engine, cache);
+        } else {
+            serve_socket(socket_path, engine);
+        }
+        return 0;
+    }
+
+    // should be 4 arguments: formula file, trace file, output file, followed by optional flags
+    // -p: print results
+    // -memo: evaluate top-down, memoizing every (subformula, suffix) verdict
+    // -dp: evaluate with the bottom-up dynamic programming engine
+    // -bits: evaluate with the bit-packed engine
+    // -rle: evaluate on run-length encoded segments
+    // -sliced: evaluate with the bit-sliced engine (one lane for a single trace)
+    // -j N: with -dp, evaluate the trace on N threads, chunked along time (0: one per core)
+    // --profile [json file]: print the time and counts of every subformula
+    //                        and write them to the json file
+    if (argc < 4) {
         throw invalid_argument("Incorrect number of arguments.");
     }
     string formula_file = argv[1];
     string trace_file = argv[2];
     string output_file = argv[3];
     bool print = false;
-    if (argc == 5) {
-        string print_flag = argv[4];
-        if (print_flag == "-p") {
+    string profile_file;
+    int threads = 1;
+    Engine engine = Engine::RECURSIVE;
+    for (int i = 4; i < argc; ++i) {
+        string flag = argv[i];
+        if (flag == "-p") {
             print = true;
-        } else {
+        } else if (flag == "--profile") {
+            if (i + 1 >= argc) {
+                throw invalid_argument("--profile expects an output file.");
+            }
+            profile_file = argv[++i];
+        } else if (flag == "-j") {
+            string count = (i + 1 < argc) ? argv[++i] : "";
+            if (count.empty() || !all_of(count.begin(), count.end(), ::isdigit)) {
+                throw invalid_argument("-j expects a number of threads.");
+            }
+            threads = stoi(count);
+            if (threads == 0) {
+                threads = hardware_threads();
+            }
+        } else if (!parse_engine_flag(flag, engine)) {
             throw invalid_argument("Incorrect flag.");
         }
     }
@@ -37,16 +141,45 @@ int main(int argc, char** argv) {
         }
     }
     formula = strip_char(formula, ' ');
+    CompiledFormula parsed = compile_mltl(formula);
+    CompiledFormula compiled = simplify(parsed);
+    string simplified = formula_to_string(compiled) + " (" + simplify_report(parsed, compiled) + ")";
 
     // read in trace from file
-    vector<string> trace = read_from_file(trace_file);
-    for (int i = 0; i < trace.size(); ++i) {
-        trace[i] = strip_char(trace[i], ' ');
-        trace[i] = strip_char(trace[i], ',');
+    vector<string> trace;
+    if (!is_trace_set(trace_file) && has_signal_names(trace_file)) {
+        // a CSV file with a header row, load only the columns the formula reads
+        SignalStore store(trace_file);
+        vector<size_t> columns;
+        compiled = bind_signals(compiled, store.signals(), columns);
+        trace = unpack_trace(store.load(0, columns));
+    } else {
+        check_no_signals(compiled);
+        trace = read_from_file(trace_file);
+        for (int i = 0; i < trace.size(); ++i) {
+            trace[i] = strip_char(trace[i], ' ');
+            trace[i] = strip_char(trace[i], ',');
+        }
+    }
+
+    if (threads > 1 && engine != Engine::DP) {
+        throw invalid_argument("-j needs -dp.");
+    }
+
+    if (!profile_file.empty() && threads > 1) {
+        throw invalid_argument("--profile runs on one thread.");
     }
 
     // evaluate formula on trace
-    bool eval = evaluate_mltl(formula, trace, false);
+    bool eval;
+    Profile profile(compiled);
+    if (!profile_file.empty()) {
+        eval = evaluate_profiled(compiled, trace, engine, profile);
+    } else if (threads > 1) {
+        eval = evaluate_dp_parallel(compiled, trace, threads);
+    } else {
+        eval = evaluate(compiled, trace, engine);
+    }
     // write to output file
     ofstream out(output_file);
     out << eval;
@@ -56,6 +189,7 @@ int main(int argc, char** argv) {
     // print results
     if (print) {
         cout << "Formula: " << formula << endl;
+        cout << "Simplified: " << simplified << endl;
         cout << "Trace: " << endl;
         for (int i = 0; i < trace.size(); ++i) {
             cout << i << ": " << trace[i] << endl;
@@ -67,5 +201,11 @@ int main(int argc, char** argv) {
         }
     }
 
+    if (!profile_file.empty()) {
+        cout << profile_table(compiled, profile);
+        ofstream json(profile_file);
+        json << profile_json(compiled, profile);
+    }
+
     return 0;
 }
\ No newline at end of file
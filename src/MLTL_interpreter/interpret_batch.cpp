@@ -3,25 +3,66 @@
 #include <string>
 #include <fstream>
 #include <tuple>
+#include <algorithm>
+#include <cctype>
+#include <numeric>
+#include <mutex>
 #include "utils.h"
 #include "evaluate_mltl.h"
+#include "evaluate_sliced.h"
+#include "work_pool.h"
+#include "trace_set.h"
+#include "summary_file.h"
+#include "evaluate_bits.h"
+#include "simplify.h"
+#include "signal_store.h"
+#include "profile.h"
 
 using namespace std;
 
 int main(int argc, char** argv) {
-    // should be 4 arguments: formula file, trace directory, output file, and optional flag for printing
-    if (argc != 4 && argc != 5) {
+    // should be 4 arguments: formula file, trace directory, output file, followed by optional flags
+    // the trace directory may also be a trace-set file written by trace_pack,
+    // a CSV file with a header row naming its columns,
+    // or a file with one trace per line such as a dataset's pos_summary.txt
+    // -p: print results
+    // -memo: evaluate top-down, memoizing every (subformula, suffix) verdict
+    // -dp: evaluate with the bottom-up dynamic programming engine
+    // -bits: evaluate with the bit-packed engine
+    // -rle: evaluate on run-length encoded segments
+    // -sliced: evaluate up to 64 traces per pass, one trace per bit lane
+    // -j N: evaluate on N threads (0: one per core)
+    // --profile [json file]: print the time and counts of every subformula
+    //                        and write them to the json file
+    if (argc < 4) {
         throw invalid_argument("Incorrect number of arguments.");
     }
     string formula_file = argv[1];
     string trace_dir = argv[2];
     string output_file = argv[3];
     bool printing = false;
-    if (argc == 5) {
-        string print_flag = argv[4];
-        if (print_flag == "-p") {
+    string profile_file;
+    int threads = 1;
+    Engine engine = Engine::RECURSIVE;
+    for (int i = 4; i < argc; ++i) {
+        string flag = argv[i];
+        if (flag == "-p") {
             printing = true;
-        } else {
+        } else if (flag == "--profile") {
+            if (i + 1 >= argc) {
+                throw invalid_argument("--profile expects an output file.");
+            }
+            profile_file = argv[++i];
+        } else if (flag == "-j") {
+            string count = (i + 1 < argc) ? argv[++i] : "";
+            if (count.empty() || !all_of(count.begin(), count.end(), ::isdigit)) {
+                throw invalid_argument("-j expects a number of threads.");
+            }
+            threads = stoi(count);
+            if (threads == 0) {
+                threads = hardware_threads();
+            }
+        } else if (!parse_engine_flag(flag, engine)) {
             throw invalid_argument("Incorrect flag.");
         }
     }
@@ -39,25 +80,125 @@ int main(int argc, char** argv) {
         }
     }
     formula = strip_char(formula, ' ');
+    CompiledFormula parsed = compile_mltl(formula);
+    CompiledFormula compiled = simplify(parsed);
+    if (printing) {
+        cout << "Simplified: " << formula_to_string(compiled) << " (" << simplify_report(parsed, compiled) << ")" << endl;
+    }
     // cout << "Finished reading formula from file." << endl << endl;
 
     // read in batch of traces from file
     // cout << "Reading batch of traces from file..." << endl;
-    vector<NamedTrace> batch = read_batch_from_file(trace_dir);
+    vector<NamedTrace> batch;
+    vector<PackedTrace> packed; // only for summary files and signal stores, read straight into bits
+    vector<string> stores;      // files read one column at a time, see signal_store.h
+    if (is_directory(trace_dir)) {
+        vector<string> files = directory_files(trace_dir);
+        if (!files.empty() && all_of(files.begin(), files.end(), has_signal_names)) {
+            stores = files;
+            sort(stores.begin(), stores.end());
+        } else {
+            batch = read_batch_from_file(trace_dir);
+            // directory order is arbitrary, report traces sorted by name
+            sort(batch.begin(), batch.end(), [](const NamedTrace& a, const NamedTrace& b) {
+                return a.name < b.name;
+            });
+        }
+    } else if (is_trace_set(trace_dir) || has_signal_names(trace_dir)) {
+        stores.push_back(trace_dir);
+    } else {
+        // traces are named by their line number
+        packed = read_summary_file(trace_dir);
+        for (int i = 0; i < packed.size(); ++i) {
+            batch.push_back(NamedTrace{to_string(i), {}});
+        }
+    }
+    if (stores.empty()) {
+        check_no_signals(compiled);
+    } else {
+        // only the columns the formula reads are loaded; binding numbers the
+        // variables by first use, so every store binds to the same formula
+        CompiledFormula bound;
+        for (const string& path : stores) {
+            SignalStore store(path);
+            vector<size_t> columns;
+            bound = bind_signals(compiled, store.signals(), columns);
+            for (size_t i = 0; i < store.size(); ++i) {
+                packed.push_back(store.load(i, columns));
+                batch.push_back(NamedTrace{store.name(i), {}});
+            }
+        }
+        compiled = bound;
+    }
     if (batch.size() == 0) {
         throw invalid_argument("Trace file is empty.");
     }
     // cout << "Finished reading batch of traces from file." << endl << endl;
 
-    // for each trace in batch, evaluate formula on trace
+    const bool profiling = !profile_file.empty();
+    if (profiling && engine != Engine::RECURSIVE && engine != Engine::MEMO && engine != Engine::DP) {
+        throw invalid_argument("--profile supports the default, -memo and -dp engines.");
+    }
+    // -bits evaluates packed traces as they are, the other engines take rows
+    const bool use_packed = !packed.empty() && engine == Engine::BITS && !profiling;
+    if (!packed.empty()) {
+        if (!use_packed) {
+            // unpacked rows have no spaces or commas to strip
+            for (int i = 0; i < batch.size(); ++i) {
+                batch[i].trace = unpack_trace(packed[i]);
+            }
+        }
+    } else {
+        // strip every trace up front, the sliced engine needs all of them at once
+        for (int i = 0; i < batch.size(); ++i) {
+            vector<string>& trace = batch[i].trace;
+            for (int j = 0; j < trace.size(); ++j) {
+                trace[j] = strip_char(trace[j], ' ');
+                trace[j] = strip_char(trace[j], ',');
+            }
+        }
+    }
+    Profile profile(compiled);
+    mutex profile_lock;
+
+    // evaluate every trace first, sharing the compiled formula between threads
+    vector<char> evals(batch.size());
+    if (engine == Engine::SLICED) {
+        vector<TraceView> views;
+        for (int i = 0; i < batch.size(); ++i) {
+            views.push_back(TraceView(batch[i].trace));
+        }
+        vector<bool> sliced_evals = evaluate_sliced(compiled, views, threads);
+        copy(sliced_evals.begin(), sliced_evals.end(), evals.begin());
+    } else {
+        // longest traces first, so a long trace never ends up last on a thread
+        vector<size_t> order(batch.size());
+        iota(order.begin(), order.end(), 0);
+        auto length = [&](size_t i) { return use_packed ? packed[i].length : batch[i].trace.size(); };
+        stable_sort(order.begin(), order.end(), [&](size_t i, size_t j) {
+            return length(i) > length(j);
+        });
+        parallel_for(order.size(), threads, [&](size_t k) {
+            size_t i = order[k];
+            if (profiling) {
+                // counted per trace, then added up, so threads never share counters
+                Profile trace_profile(compiled);
+                evals[i] = evaluate_profiled(compiled, TraceView(batch[i].trace), engine, trace_profile);
+                lock_guard<mutex> guard(profile_lock);
+                profile.merge(trace_profile);
+            } else if (use_packed) {
+                evals[i] = evaluate_bits(compiled, packed[i]);
+            } else {
+                evals[i] = evaluate(compiled, TraceView(batch[i].trace), engine);
+            }
+        });
+    }
+
+    // write the verdicts in trace order
     ofstream out;
     out.open(output_file);
     for (int i = 0; i < batch.size(); ++i) {
-        vector<string> trace = batch[i].trace;
-        for (int j = 0; j < trace.size(); ++j) {
-            trace[j] = strip_char(trace[j], ' ');
-            trace[j] = strip_char(trace[j], ',');
-        }
+        const vector<string>& trace = batch[i].trace;
         // print trace in one line
         // for (int j = 0; j < trace.size(); ++j) {
         //     out << trace[j] << " ";
@@ -65,17 +206,23 @@ int main(int argc, char** argv) {
     
         // evaluate formula on trace
         // cout << "Evaluating formula on trace " << i << "..." << endl;
-        bool eval = evaluate_mltl(formula, trace, false);
+        bool eval = evals[i];
         // cout << "Finished evaluating formula on trace " << i << "." << endl << endl;
         // write to output file
         out <<batch[i].name << " : " << eval << endl;
 
         // print results
         if (printing) {
+            // -bits left the trace packed, unpack it only to print it
+            vector<string> unpacked;
+            if (use_packed) {
+                unpacked = unpack_trace(packed[i]);
+            }
+            const vector<string>& rows = use_packed ? unpacked : trace;
             cout << "Formula: " << formula << endl;
             cout << "Trace: " << endl;
-            for (int i = 0; i < trace.size(); ++i) {
-                cout << i << ": " << trace[i] << endl;
+            for (int i = 0; i < rows.size(); ++i) {
+                cout << i << ": " << rows[i] << endl;
             }
             if (eval) {
                 cout << "evaluation: true" << endl;
@@ -86,5 +233,11 @@ int main(int argc, char** argv) {
     }
     out.close();
 
+    if (profiling) {
+        cout << profile_table(compiled, profile);
+        ofstream json(profile_file);
+        json << profile_json(compiled, profile);
+    }
+
     return 0;
 }
\ No newline at end of file
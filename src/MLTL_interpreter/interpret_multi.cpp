@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "utils.h"
+#include "compile_mltl.h"
+#include "formula_dag.h"
+#include "simplify.h"
+#include "signal_store.h"
+#include "trace_set.h"
+#include "work_pool.h"
+
+using namespace std;
+
+int main(int argc, char** argv) {
+    // should be 4 arguments: formula file, trace directory, output file, followed by optional flags
+    // the formula file holds one formula per line, each evaluated on its own
+    // the trace directory may also be a trace-set file written by trace_pack
+    // -p: print how many subformulas the formulas share
+    // -j N: evaluate on N threads (0: one per core)
+    if (argc < 4) {
+        throw invalid_argument("Incorrect number of arguments.");
+    }
+    string formula_file = argv[1];
+    string trace_dir = argv[2];
+    string output_file = argv[3];
+    bool printing = false;
+    int threads = 1;
+    for (int i = 4; i < argc; ++i) {
+        string flag = argv[i];
+        if (flag == "-p") {
+            printing = true;
+        } else if (flag == "-j") {
+            string count = (i + 1 < argc) ? argv[++i] : "";
+            if (count.empty() || !all_of(count.begin(), count.end(), ::isdigit)) {
+                throw invalid_argument("-j expects a number of threads.");
+            }
+            threads = stoi(count);
+            if (threads == 0) {
+                threads = hardware_threads();
+            }
+        } else {
+            throw invalid_argument("Incorrect flag.");
+        }
+    }
+
+    // read in formulas from file, one per line
+    vector<CompiledFormula> formulas;
+    FormulaStats parsed_stats, simplified_stats;
+    for (string formula : read_from_file(formula_file)) {
+        formula = strip_char(formula, ' ');
+        if (!formula.empty()) {
+            CompiledFormula parsed = compile_mltl(formula);
+            formulas.push_back(simplify(parsed));
+            check_no_signals(formulas.back());
+            parsed_stats.nodes += formula_stats(parsed).nodes;
+            parsed_stats.cost += formula_stats(parsed).cost;
+            simplified_stats.nodes += formula_stats(formulas.back()).nodes;
+            simplified_stats.cost += formula_stats(formulas.back()).cost;
+        }
+    }
+    if (formulas.size() == 0) {
+        throw invalid_argument("Formula file is empty.");
+    }
+    FormulaDAG dag = build_dag(formulas);
+
+    // read in batch of traces, sorted by name
+    vector<NamedTrace> batch = is_trace_set(trace_dir) ? read_batch_from_trace_set(TraceSet(trace_dir))
+                                                       : read_batch_from_file(trace_dir);
+    if (batch.size() == 0) {
+        throw invalid_argument("Trace file is empty.");
+    }
+    sort(batch.begin(), batch.end(), [](const NamedTrace& a, const NamedTrace& b) {
+        return a.name < b.name;
+    });
+    vector<TraceView> views;
+    for (int i = 0; i < batch.size(); ++i) {
+        vector<string>& trace = batch[i].trace;
+        for (int j = 0; j < trace.size(); ++j) {
+            trace[j] = strip_char(trace[j], ' ');
+            trace[j] = strip_char(trace[j], ',');
+        }
+        views.push_back(TraceView(trace));
+    }
+
+    vector<vector<bool>> matrix = evaluate_dag(dag, views, threads);
+
+    // first line: trace names, then one line of verdicts per formula
+    ofstream out(output_file);
+    for (int i = 0; i < batch.size(); ++i) {
+        out << (i ? "," : "") << batch[i].name;
+    }
+    out << endl;
+    for (const vector<bool>& row : matrix) {
+        for (int i = 0; i < row.size(); ++i) {
+            out << (i ? "," : "") << row[i];
+        }
+        out << endl;
+    }
+    out.close();
+
+    if (printing) {
+        cout << "Formulas: " << formulas.size() << endl;
+        cout << "Simplified: nodes " << parsed_stats.nodes << " -> " << simplified_stats.nodes << ", cost "
+             << (long long) parsed_stats.cost << " -> " << (long long) simplified_stats.cost << endl;
+        cout << "Subformulas: " << dag.input_nodes << ", distinct: " << dag.nodes.size() << endl;
+        cout << "Traces: " << batch.size() << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include "utils.h"
+#include "compile_mltl.h"
+#include "codegen.h"
+#include "simplify.h"
+#include "signal_store.h"
+
+using namespace std;
+
+int main(int argc, char** argv) {
+    // mltl_codegen [formula file] [output file] [-so path | -bin path]
+    // writes the C++ source of an evaluator specialized to the formula,
+    // lines of the formula file are conjoined as in interpret
+    // -so: also build it into a shared object exporting mltl_evaluate
+    // -bin: also build it into a standalone program over a traces file
+    if (argc != 3 && argc != 5) {
+        throw invalid_argument("Incorrect number of arguments.");
+    }
+    string formula_file = argv[1];
+    string output_file = argv[2];
+    string build_flag = (argc == 5) ? argv[3] : "";
+    if (argc == 5 && build_flag != "-so" && build_flag != "-bin") {
+        throw invalid_argument("Incorrect flag.");
+    }
+
+    vector<string> formula_vec = read_from_file(formula_file);
+    if (formula_vec.size() == 0) {
+        throw invalid_argument("Formula file is empty.");
+    }
+    string formula = formula_vec[0];
+    for (int i = 1; i < formula_vec.size(); ++i) {
+        formula = "(" + formula + "&" + formula_vec[i] + ")";
+    }
+    formula = strip_char(formula, ' ');
+    CompiledFormula compiled = simplify(compile_mltl(formula));
+    check_no_signals(compiled);
+
+    ofstream out(output_file);
+    out << generate_evaluator(compiled);
+    out.close();
+
+    if (build_flag.empty()) {
+        return 0;
+    }
+    string command = "g++ -O2 -std=c++17 ";
+    if (build_flag == "-so") {
+        command += "-shared -fPIC ";
+    } else {
+        command += "-DMLTL_CODEGEN_MAIN ";
+    }
+    command += "\"" + output_file + "\" -o \"" + string(argv[4]) + "\"";
+    return system(command.c_str()) == 0 ? 0 : 1;
+}
@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "packed_trace.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86 1
+#endif
+
+using namespace std;
+
+/*
+ * Number of words needed for a bit vector over positions [0, length]
+ */
+size_t words_for(size_t length) {
+    return (length + 1 + 63) / 64;
+}
+
+/*
+ * Packs trace T into one bit column per variable.
+ * The number of variables is the width of the widest timestep.
+ */
+PackedTrace pack_trace(TraceView T) {
+    PackedTrace P;
+    P.length = T.size();
+    for (size_t t = 0; t < T.size(); ++t) {
+        P.num_vars = max(P.num_vars, T[t].length());
+    }
+    P.words = words_for(P.length);
+    P.columns.assign(P.num_vars * P.words, 0);
+    for (size_t t = 0; t < T.size(); ++t) {
+        const string& row = T[t];
+        for (size_t p = 0; p < row.length(); ++p) {
+            if (row[p] != '0') {
+                P.columns[p * P.words + t / 64] |= uint64_t(1) << (t % 64);
+            }
+        }
+    }
+    return P;
+}
+
+vector<string> unpack_trace(const PackedTrace& P) {
+    vector<string> T(P.length, string(P.num_vars, '0'));
+    for (size_t p = 0; p < P.num_vars; ++p) {
+        const uint64_t* col = P.column(p);
+        for (size_t t = 0; t < P.length; ++t) {
+            if (get_bit(col, t)) {
+                T[t][p] = '1';
+            }
+        }
+    }
+    return T;
+}
+
+bool get_bit(const uint64_t* v, size_t i) {
+    return (v[i / 64] >> (i % 64)) & 1;
+}
+
+void set_bit(uint64_t* v, size_t i, bool value) {
+    if (value) {
+        v[i / 64] |= uint64_t(1) << (i % 64);
+    } else {
+        v[i / 64] &= ~(uint64_t(1) << (i % 64));
+    }
+}
+
+/*
+ * Sets bits [from, to) of v to value
+ */
+void set_range(uint64_t* v, size_t from, size_t to, bool value) {
+    while (from < to && from % 64 != 0) {
+        set_bit(v, from++, value);
+    }
+    while (from + 64 <= to) {
+        v[from / 64] = value ? ~uint64_t(0) : 0;
+        from += 64;
+    }
+    while (from < to) {
+        set_bit(v, from++, value);
+    }
+}
+
+/*
+ * Runtime dispatch: the AVX2 versions are compiled with a target attribute,
+ * so the binary still runs on CPUs without AVX2.
+ */
+#ifdef HAVE_X86
+__attribute__((target("avx2")))
+static void bits_and_avx2(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i*)(b + i));
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_and_si256(x, y));
+    }
+    for (; i < n; ++i) {
+        out[i] = a[i] & b[i];
+    }
+}
+
+__attribute__((target("avx2")))
+static void bits_or_avx2(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i*)(b + i));
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_or_si256(x, y));
+    }
+    for (; i < n; ++i) {
+        out[i] = a[i] | b[i];
+    }
+}
+
+__attribute__((target("avx2")))
+static void bits_andnot_avx2(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i*)(b + i));
+        // _mm256_andnot_si256 negates its first operand
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_andnot_si256(y, x));
+    }
+    for (; i < n; ++i) {
+        out[i] = a[i] & ~b[i];
+    }
+}
+
+__attribute__((target("avx2")))
+static void bits_not_avx2(const uint64_t* a, uint64_t* out, size_t n) {
+    size_t i = 0;
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_xor_si256(x, ones));
+    }
+    for (; i < n; ++i) {
+        out[i] = ~a[i];
+    }
+}
+#endif
+
+/*
+ * Returns true if the word-parallel kernels dispatch to the AVX2 path
+ */
+bool avx2_enabled() {
+#ifdef HAVE_X86
+    static const bool enabled = __builtin_cpu_supports("avx2");
+    return enabled;
+#else
+    return false;
+#endif
+}
+
+void bits_and(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n) {
+#ifdef HAVE_X86
+    if (avx2_enabled()) {
+        return bits_and_avx2(a, b, out, n);
+    }
+#endif
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = a[i] & b[i];
+    }
+}
+
+void bits_or(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n) {
+#ifdef HAVE_X86
+    if (avx2_enabled()) {
+        return bits_or_avx2(a, b, out, n);
+    }
+#endif
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = a[i] | b[i];
+    }
+}
+
+void bits_andnot(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n) {
+#ifdef HAVE_X86
+    if (avx2_enabled()) {
+        return bits_andnot_avx2(a, b, out, n);
+    }
+#endif
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = a[i] & ~b[i];
+    }
+}
+
+void bits_not(const uint64_t* a, uint64_t* out, size_t n) {
+#ifdef HAVE_X86
+    if (avx2_enabled()) {
+        return bits_not_avx2(a, out, n);
+    }
+#endif
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = ~a[i];
+    }
+}
+
+/*
+ * out[s] = a[s + k], bits shifted in from past the end are fill.
+ * out must not alias a.
+ */
+void bits_shift_down(const uint64_t* a, uint64_t* out, size_t n, size_t k, bool fill) {
+    const uint64_t pad = fill ? ~uint64_t(0) : 0;
+    const size_t q = k / 64, r = k % 64;
+    for (size_t w = 0; w < n; ++w) {
+        uint64_t lo = (w + q < n) ? a[w + q] : pad;
+        if (r == 0) {
+            out[w] = lo;
+        } else {
+            uint64_t hi = (w + q + 1 < n) ? a[w + q + 1] : pad;
+            out[w] = (lo >> r) | (hi << (64 - r));
+        }
+    }
+}
+
+/*
+ * Doubles the covered window each pass: after the loop, out[s] covers
+ * a[s .. s+len-1], and one more overlapping pass extends it to w.
+ */
+static void bits_window(const uint64_t* a, uint64_t* out, size_t n, size_t w, bool is_or) {
+    vector<uint64_t> shifted(n);
+    memmove(out, a, n * sizeof(uint64_t));
+    w = min(w, n * 64); // wider windows only add padding bits
+    size_t len = 1;
+    while (len < w) {
+        size_t step = min(len, w - len);
+        bits_shift_down(out, shifted.data(), n, step, !is_or);
+        if (is_or) {
+            bits_or(out, shifted.data(), out, n);
+        } else {
+            bits_and(out, shifted.data(), out, n);
+        }
+        len += step;
+    }
+}
+
+/*
+ * Sliding window over width w >= 1: out[s] = OR (resp. AND) of a[s .. s+w-1],
+ * bits past word n count as 0 for OR and 1 for AND.
+ * Takes O(n log w) word operations.
+ */
+void bits_window_or(const uint64_t* a, uint64_t* out, size_t n, size_t w) {
+    bits_window(a, out, n, w, true);
+}
+
+void bits_window_and(const uint64_t* a, uint64_t* out, size_t n, size_t w) {
+    bits_window(a, out, n, w, false);
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "utils.h"
+
+using namespace std;
+
+/*
+ * Bit vector over timesteps, bit t lives in word t / 64 at position t % 64.
+ * Bits past the logical length are kept zero.
+ */
+typedef vector<uint64_t> BitVector;
+
+/*
+ * Columnar bit-packed trace: one bit column per propositional variable,
+ * packed along the time axis. Each column holds length+1 bits so that
+ * position length (the empty suffix) has a slot, and that bit is always 0.
+ */
+struct PackedTrace {
+    size_t length = 0;   // number of timesteps
+    size_t num_vars = 0; // number of propositional variables
+    size_t words = 0;    // words per column
+    vector<uint64_t> columns; // column p occupies [p * words, (p+1) * words)
+
+    const uint64_t* column(size_t p) const { return columns.data() + p * words; }
+};
+
+/*
+ * Number of words needed for a bit vector over positions [0, length]
+ */
+size_t words_for(size_t length);
+
+/*
+ * Packs trace T into one bit column per variable.
+ * The number of variables is the width of the widest timestep.
+ */
+PackedTrace pack_trace(TraceView T);
+
+/*
+ * Unpacks P back into rows of '0'/'1', one per timestep
+ */
+vector<string> unpack_trace(const PackedTrace& P);
+
+bool get_bit(const uint64_t* v, size_t i);
+void set_bit(uint64_t* v, size_t i, bool value);
+
+/*
+ * Sets bits [from, to) of v to value
+ */
+void set_range(uint64_t* v, size_t from, size_t to, bool value);
+
+/*
+ * Word-parallel boolean kernels over n words. Each one runs 256 bits per
+ * instruction with AVX2 when the CPU supports it, 64 bits otherwise.
+ * out may alias an input.
+ */
+void bits_and(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n);
+void bits_or(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n);
+void bits_andnot(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n); // a & ~b
+void bits_not(const uint64_t* a, uint64_t* out, size_t n);
+
+/*
+ * out[s] = a[s + k], bits shifted in from past the end are fill.
+ * out must not alias a.
+ */
+void bits_shift_down(const uint64_t* a, uint64_t* out, size_t n, size_t k, bool fill);
+
+/*
+ * Sliding window over width w >= 1: out[s] = OR (resp. AND) of a[s .. s+w-1],
+ * bits past word n count as 0 for OR and 1 for AND.
+ * Takes O(n log w) word operations.
+ */
+void bits_window_or(const uint64_t* a, uint64_t* out, size_t n, size_t w);
+void bits_window_and(const uint64_t* a, uint64_t* out, size_t n, size_t w);
+
+/*
+ * Returns true if the word-parallel kernels dispatch to the AVX2 path
+ */
+bool avx2_enabled();
@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include "profile.h"
+
+using namespace std;
+
+void Profile::merge(const Profile& other) {
+    nodes.resize(max(nodes.size(), other.nodes.size()));
+    for (size_t i = 0; i < other.nodes.size(); ++i) {
+        nodes[i].evaluations += other.nodes[i].evaluations;
+        nodes[i].memo_hits += other.nodes[i].memo_hits;
+        nodes[i].short_circuits += other.nodes[i].short_circuits;
+        nodes[i].total_ns += other.nodes[i].total_ns;
+        nodes[i].self_ns += other.nodes[i].self_ns;
+    }
+    top_down = other.top_down;
+    memo = other.memo;
+}
+
+/*
+ * Returns true if op can decide its verdict before reading all of its operands
+ */
+static bool can_short_circuit(MLTLOp op) {
+    return op == MLTLOp::AND || op == MLTLOp::OR || op == MLTLOp::IMPLIES || is_temporal(op);
+}
+
+static string percent(uint64_t part, uint64_t whole) {
+    if (whole == 0) {
+        return "-";
+    }
+    ostringstream out;
+    out << fixed << setprecision(1) << 100.0 * part / whole << "%";
+    return out.str();
+}
+
+static string milliseconds(double ns) {
+    ostringstream out;
+    out << fixed << setprecision(3) << ns / 1e6;
+    return out.str();
+}
+
+static void table_rows(const CompiledFormula& CF, const Profile& P, int node, int depth,
+                       vector<char>& shown, ostringstream& out) {
+    const int bar_width = 20;
+    const size_t label_width = 60;
+    const NodeProfile& p = P.nodes[node];
+    const MLTLNode& n = CF.nodes[node];
+
+    string label = formula_to_string(CF, node);
+    if (label.length() > label_width) {
+        label = label.substr(0, label_width - 3) + "...";
+    }
+    label = string(2 * depth, ' ') + label;
+    if (shown[node]) {
+        // a subformula shared by several parents is listed under the first
+        out << setw(10) << "" << setw(10) << "" << setw(14) << "" << setw(10) << "" << setw(10) << ""
+            << "  " << string(bar_width, ' ') << "  " << label << " (shared, see above)" << endl;
+        return;
+    }
+    shown[node] = 1;
+
+    const double root_ns = P.nodes[CF.root].total_ns;
+    int bar = (root_ns > 0) ? (int) (bar_width * p.total_ns / root_ns + 0.5) : 0;
+    bar = min(bar, bar_width);
+    const uint64_t computed = p.evaluations - p.memo_hits;
+    out << setw(10) << milliseconds(p.total_ns) << setw(10) << milliseconds(p.self_ns) << setw(14) << p.evaluations
+        << setw(10) << (P.memo ? percent(p.memo_hits, p.evaluations) : "-")
+        << setw(10) << (P.top_down && can_short_circuit(n.op) ? percent(p.short_circuits, computed) : "-")
+        << "  " << string(bar, '#') << string(bar_width - bar, '.') << "  " << label << endl;
+    if (n.left != -1) {
+        table_rows(CF, P, n.left, depth + 1, shown, out);
+    }
+    if (n.right != -1) {
+        table_rows(CF, P, n.right, depth + 1, shown, out);
+    }
+}
+
+string profile_table(const CompiledFormula& CF, const Profile& P) {
+    ostringstream out;
+    out << setw(10) << "total ms" << setw(10) << "self ms" << setw(14)
+        << (P.top_down ? "evaluations" : "positions") << setw(10) << "memo hit" << setw(10) << "short" << "  "
+        << left << setw(20) << "time" << right << "  subformula" << endl;
+    vector<char> shown(CF.nodes.size(), 0);
+    if (CF.root != -1) {
+        table_rows(CF, P, CF.root, 0, shown, out);
+    }
+    return out.str();
+}
+
+static string json_string(const string& s) {
+    string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out + "\"";
+}
+
+string profile_json(const CompiledFormula& CF, const Profile& P) {
+    ostringstream out;
+    out << "{\n  \"top_down\": " << (P.top_down ? "true" : "false")
+        << ",\n  \"memo\": " << (P.memo ? "true" : "false")
+        << ",\n  \"root\": " << CF.root << ",\n  \"nodes\": [";
+    for (size_t i = 0; i < CF.nodes.size(); ++i) {
+        const NodeProfile& p = P.nodes[i];
+        const MLTLNode& n = CF.nodes[i];
+        out << (i ? "," : "") << "\n    {\"id\": " << i << ", \"formula\": " << json_string(formula_to_string(CF, i))
+            << ", \"left\": " << n.left << ", \"right\": " << n.right
+            << ", \"evaluations\": " << p.evaluations << ", \"memo_hits\": " << p.memo_hits
+            << ", \"short_circuits\": " << p.short_circuits
+            << ", \"total_ms\": " << milliseconds(p.total_ns) << ", \"self_ms\": " << milliseconds(p.self_ns) << "}";
+    }
+    out << "\n  ]\n}\n";
+    return out.str();
+}
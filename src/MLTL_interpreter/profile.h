@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "compile_mltl.h"
+
+using namespace std;
+
+/*
+ * What evaluation spent on one node of a compiled formula
+ */
+struct NodeProfile {
+    uint64_t evaluations = 0;    // verdicts asked for, memo hits included
+    uint64_t memo_hits = 0;      // verdicts answered from the memo table
+    uint64_t short_circuits = 0; // computed verdicts decided before the whole window was read
+    double total_ns = 0;         // time in the node, operands included
+    double self_ns = 0;          // time in the node, operands excluded
+};
+
+/*
+ * Per-node counters of one or more evaluations of the same formula.
+ * Only the profiling entry points fill it in, the plain evaluators are
+ * compiled without any of it.
+ */
+struct Profile {
+    vector<NodeProfile> nodes;
+    bool top_down = true; // counts are per (node, suffix), not per position
+    bool memo = false;
+
+    // time spent in the operands of the node being computed, for self_ns
+    double operand_ns = 0;
+
+    Profile() = default;
+    explicit Profile(const CompiledFormula& CF) : nodes(CF.nodes.size()) {}
+
+    /*
+     * Adds the counters of other, a profile of the same formula
+     */
+    void merge(const Profile& other);
+};
+
+/*
+ * Flame-style table of P, one row per subformula in pre-order, indented by
+ * depth, with a bar proportional to the time spent in it
+ */
+string profile_table(const CompiledFormula& CF, const Profile& P);
+
+/*
+ * P as a JSON object, one entry per node, indexed like CF.nodes
+ */
+string profile_json(const CompiledFormula& CF, const Profile& P);
@@ -0,0 +1,236 @@
+#include <csignal>
+#include <cstdint>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "serve.h"
+#include "evaluate_sliced.h"
+#include "eval_session.h"
+#include "simplify.h"
+#include "signal_store.h"
+#include "utils.h"
+
+using namespace std;
+
+// frames larger than this are taken as a broken client
+const uint32_t MAX_FRAME = 1u << 30;
+
+static bool read_all(int fd, char* buf, size_t n) {
+    while (n > 0) {
+        ssize_t got = read(fd, buf, n);
+        if (got <= 0) {
+            return false;
+        }
+        buf += got;
+        n -= got;
+    }
+    return true;
+}
+
+static bool write_all(int fd, const char* buf, size_t n) {
+    while (n > 0) {
+        ssize_t put = write(fd, buf, n);
+        if (put <= 0) {
+            return false;
+        }
+        buf += put;
+        n -= put;
+    }
+    return true;
+}
+
+static bool read_frame(int fd, string& payload) {
+    unsigned char len[4];
+    if (!read_all(fd, (char*) len, 4)) {
+        return false;
+    }
+    uint32_t n = len[0] | (len[1] << 8) | (len[2] << 16) | ((uint32_t) len[3] << 24);
+    if (n > MAX_FRAME) {
+        return false;
+    }
+    payload.resize(n);
+    return read_all(fd, &payload[0], n);
+}
+
+static bool write_frame(int fd, const string& payload) {
+    uint32_t n = payload.size();
+    unsigned char len[4] = {(unsigned char) n, (unsigned char) (n >> 8), (unsigned char) (n >> 16),
+                            (unsigned char) (n >> 24)};
+    return write_all(fd, (const char*) len, 4) && write_all(fd, payload.data(), payload.size());
+}
+
+/*
+ * Splits s at every c
+ */
+static vector<string> split(const string& s, char c) {
+    vector<string> parts;
+    size_t begin = 0;
+    while (true) {
+        size_t end = s.find(c, begin);
+        parts.push_back(s.substr(begin, end - begin));
+        if (end == string::npos) {
+            return parts;
+        }
+        begin = end + 1;
+    }
+}
+
+static string compile_request(const string& body, FormulaCache& cache) {
+    string formula = strip_char(strip_char(body, ' '), '\n');
+    auto it = cache.ids.find(formula);
+    if (it == cache.ids.end()) {
+        CompiledFormula compiled = simplify(compile_mltl(formula));
+        // traces arrive as rows of '0'/'1' without column names
+        check_no_signals(compiled);
+        cache.formulas.push_back(compiled);
+        it = cache.ids.emplace(formula, cache.formulas.size() - 1).first;
+    }
+    return "ok " + to_string(it->second);
+}
+
+static string eval_request(const vector<string>& args, const string& body, Engine engine,
+                           const FormulaCache& cache) {
+    if (args.size() != 3) {
+        throw invalid_argument("eval expects a formula id and a number of traces.");
+    }
+    int id = stoi(args[1]);
+    size_t n = stoul(args[2]);
+    if (id < 0 || id >= cache.formulas.size()) {
+        throw invalid_argument("Unknown formula id " + args[1] + ".");
+    }
+    const CompiledFormula& CF = cache.formulas[id];
+
+    vector<string> lines = (n == 0) ? vector<string>() : split(body, '\n');
+    if (lines.size() == n + 1 && lines.back().empty()) {
+        lines.pop_back(); // trailing newline
+    }
+    if (lines.size() != n) {
+        throw invalid_argument("Expected " + to_string(n) + " traces, got " + to_string(lines.size()) + ".");
+    }
+    vector<vector<string>> traces(n);
+    vector<TraceView> views;
+    for (size_t i = 0; i < n; ++i) {
+        string line = strip_char(lines[i], ' ');
+        if (!line.empty()) {
+            traces[i] = split(line, ',');
+        }
+        views.push_back(TraceView(traces[i]));
+    }
+
+    vector<bool> verdicts;
+    if (engine == Engine::SLICED) {
+        verdicts = evaluate_sliced(CF, views);
+    } else {
+        for (const TraceView& T : views) {
+            verdicts.push_back(evaluate(CF, T, engine));
+        }
+    }
+    string bitmap((n + 7) / 8, '\0');
+    for (size_t i = 0; i < n; ++i) {
+        if (verdicts[i]) {
+            bitmap[i / 8] |= 1 << (i % 8);
+        }
+    }
+    return "ok " + to_string(n) + "\n" + bitmap;
+}
+
+static string session_request(const vector<string>& args, const FormulaCache& cache,
+                              vector<EvalSession>& sessions) {
+    if (args.size() != 2) {
+        throw invalid_argument("session expects a formula id.");
+    }
+    int id = stoi(args[1]);
+    if (id < 0 || id >= cache.formulas.size()) {
+        throw invalid_argument("Unknown formula id " + args[1] + ".");
+    }
+    sessions.push_back(EvalSession(cache.formulas[id]));
+    return "ok " + to_string(sessions.size() - 1);
+}
+
+static string append_request(const vector<string>& args, const string& body, vector<EvalSession>& sessions) {
+    if (args.size() != 3) {
+        throw invalid_argument("append expects a session id and a number of timesteps.");
+    }
+    int id = stoi(args[1]);
+    size_t n = stoul(args[2]);
+    if (id < 0 || id >= sessions.size()) {
+        throw invalid_argument("Unknown session id " + args[1] + ".");
+    }
+    vector<string> rows = (n == 0) ? vector<string>() : split(body, '\n');
+    if (rows.size() == n + 1 && rows.back().empty()) {
+        rows.pop_back(); // trailing newline
+    }
+    if (rows.size() != n) {
+        throw invalid_argument("Expected " + to_string(n) + " timesteps, got " + to_string(rows.size()) + ".");
+    }
+
+    EvalSession& S = sessions[id];
+    const TruthVector& verdicts = S.append(rows);
+    size_t from = S.changed_from(), length = S.length();
+    string bitmap((length - from + 7) / 8, '\0');
+    for (size_t t = from; t < length; ++t) {
+        if (verdicts[t]) {
+            bitmap[(t - from) / 8] |= 1 << ((t - from) % 8);
+        }
+    }
+    return "ok " + to_string(from) + " " + to_string(length) + "\n" + bitmap;
+}
+
+void serve_stream(int in_fd, int out_fd, Engine engine, FormulaCache& cache) {
+    vector<EvalSession> sessions;
+    string request;
+    while (read_frame(in_fd, request)) {
+        size_t newline = request.find('\n');
+        vector<string> args = split(request.substr(0, newline), ' ');
+        string body = (newline == string::npos) ? "" : request.substr(newline + 1);
+        string response;
+        bool quit = false;
+        try {
+            if (args[0] == "compile") {
+                response = compile_request(body, cache);
+            } else if (args[0] == "eval") {
+                response = eval_request(args, body, engine, cache);
+            } else if (args[0] == "session") {
+                response = session_request(args, cache, sessions);
+            } else if (args[0] == "append") {
+                response = append_request(args, body, sessions);
+            } else if (args[0] == "quit") {
+                response = "ok";
+                quit = true;
+            } else {
+                response = "error Unknown command " + args[0] + ".";
+            }
+        } catch (const exception& e) {
+            response = string("error ") + e.what();
+        }
+        if (!write_frame(out_fd, response) || quit) {
+            return;
+        }
+    }
+}
+
+void serve_socket(const string& path, Engine engine) {
+    // a client hanging up mid-response must not end the server
+    signal(SIGPIPE, SIG_IGN);
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        throw invalid_argument("Socket path " + path + " is too long.");
+    }
+    path.copy(addr.sun_path, path.size());
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path.c_str());
+    if (server < 0 || bind(server, (sockaddr*) &addr, sizeof(addr)) != 0 || listen(server, 8) != 0) {
+        throw invalid_argument("Could not listen on " + path + ".");
+    }
+    FormulaCache cache;
+    while (true) {
+        int client = accept(server, nullptr, nullptr);
+        if (client < 0) {
+            continue;
+        }
+        serve_stream(client, client, engine, cache);
+        close(client);
+    }
+}
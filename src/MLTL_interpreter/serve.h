@@ -0,0 +1,54 @@
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+#include "compile_mltl.h"
+#include "evaluate_mltl.h"
+
+using namespace std;
+
+/*
+ * interpret --serve protocol.
+ * Every message, in both directions, is a 4-byte little-endian payload
+ * length followed by the payload. The first line of a request payload is
+ * the command:
+ *
+ *   compile\n<formula>               -> ok <id>
+ *   eval <id> <n>\n<trace 1>\n...<trace n>
+ *                                    -> ok <n>\n<bitmap>
+ *   session <id>                     -> ok <sid>
+ *   append <sid> <n>\n<timestep 1>\n...<timestep n>
+ *                                    -> ok <from> <length>\n<bitmap>
+ *   quit                             -> ok, then the connection is closed
+ *
+ * Traces use the multiple trace format, timesteps separated by commas.
+ * The bitmap holds (n+7)/8 bytes, bit i % 8 of byte i / 8 is the verdict
+ * of trace i. Failed requests are answered with "error <message>" and the
+ * connection stays open.
+ *
+ * session opens an EvalSession on an empty trace for formula id, append
+ * adds n timesteps to it. Only the verdicts an append can change are sent:
+ * bit i of the bitmap is the verdict on the suffix starting at from + i,
+ * for from + i < length, the verdicts before from stay as they were.
+ * Sessions belong to the connection that opened them.
+ */
+
+/*
+ * Formulas compiled so far, the same formula text always gets the same id
+ */
+struct FormulaCache {
+    map<string, int> ids;
+    vector<CompiledFormula> formulas;
+};
+
+/*
+ * Answers requests read from in_fd on out_fd until in_fd ends or a quit
+ * request arrives
+ */
+void serve_stream(int in_fd, int out_fd, Engine engine, FormulaCache& cache);
+
+/*
+ * Listens on the UNIX socket path and serves one client at a time,
+ * sharing the formula cache between clients. Does not return.
+ */
+void serve_socket(const string& path, Engine engine);
@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "signal_store.h"
+
+using namespace std;
+
+CompiledFormula bind_signals(const CompiledFormula& CF, const vector<string>& names, vector<size_t>& columns) {
+    CompiledFormula bound = CF;
+    bound.signals.clear();
+    columns.clear();
+    // variables of CF in order of first use, so the numbering does not
+    // depend on where the source keeps its columns
+    vector<int> vars;
+    for (MLTLNode& n : bound.nodes) {
+        if (n.op != MLTLOp::PROP_VAR) {
+            continue;
+        }
+        size_t j = find(vars.begin(), vars.end(), n.var) - vars.begin();
+        if (j == vars.size()) {
+            size_t column = n.var;
+            if (n.var < 0) {
+                const string& signal = CF.signals[-n.var-1];
+                column = find(names.begin(), names.end(), signal) - names.begin();
+                if (column == names.size()) {
+                    throw invalid_argument("Unknown signal " + signal + ".");
+                }
+            }
+            vars.push_back(n.var);
+            columns.push_back(column);
+        }
+        n.var = j;
+    }
+    return bound;
+}
+
+void check_no_signals(const CompiledFormula& CF) {
+    for (const MLTLNode& n : CF.nodes) {
+        if (n.op == MLTLOp::PROP_VAR && n.var < 0) {
+            throw invalid_argument("Signal " + CF.signals[-n.var-1]
+                                   + " needs traces with signal names (a CSV header or a named trace set).");
+        }
+    }
+}
+
+/*
+ * Splits a CSV header line into column names.
+ * Returns false if line is a row of values rather than a header.
+ */
+static bool parse_header(string line, vector<string>& names) {
+    line = strip_char(strip_char(line, ' '), '\r');
+    if (!line.empty() && line[0] == '#') {
+        line = line.substr(1);
+    } else if (line.find_first_not_of("01,") == string::npos) {
+        return false;
+    }
+    names.clear();
+    size_t begin = 0;
+    while (true) {
+        size_t end = line.find(',', begin);
+        names.push_back(line.substr(begin, end - begin));
+        if (names.back().empty()) {
+            throw invalid_argument("Empty column name in CSV header.");
+        }
+        if (end == string::npos) {
+            return true;
+        }
+        begin = end + 1;
+    }
+}
+
+static bool read_csv_header(const string& path, vector<string>& names) {
+    ifstream in(path);
+    string line;
+    return getline(in, line) && parse_header(line, names);
+}
+
+bool has_signal_names(const string& path) {
+    if (is_directory(path)) {
+        return false;
+    }
+    if (is_trace_set(path)) {
+        return !TraceSet(path).signals().empty();
+    }
+    vector<string> names;
+    return read_csv_header(path, names);
+}
+
+SignalStore::SignalStore(const string& path) : path(path) {
+    if (is_trace_set(path)) {
+        set.reset(new TraceSet(path));
+        header = set->signals();
+    } else if (!read_csv_header(path, header)) {
+        throw invalid_argument(path + " has no header naming its columns.");
+    }
+}
+
+const vector<string>& SignalStore::signals() const {
+    return header;
+}
+
+size_t SignalStore::size() const {
+    return set ? set->size() : 1;
+}
+
+string SignalStore::name(size_t i) const {
+    return set ? set->name(i) : path;
+}
+
+PackedTrace SignalStore::load(size_t i, const vector<size_t>& columns) const {
+    if (set) {
+        return set->packed(i, columns);
+    }
+    // slot[k]: column of the result that CSV field k goes to, -1 if unused
+    vector<int> slot(header.size(), -1);
+    for (size_t j = 0; j < columns.size(); ++j) {
+        if (columns[j] >= header.size()) {
+            throw invalid_argument("Propositional variable p" + to_string(columns[j]) + " is out of bounds of the trace.");
+        }
+        if (slot[columns[j]] == -1) {
+            slot[columns[j]] = j;
+        }
+    }
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw invalid_argument("Could not open " + path + ".");
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        throw invalid_argument("Could not read " + path + ".");
+    }
+    const size_t bytes = st.st_size;
+    void* mapped = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        throw invalid_argument("Could not map " + path + ".");
+    }
+    const char* end = (const char*) mapped + bytes;
+    const char* rows = (const char*) mapped;
+    while (rows < end && *rows != '\n') {
+        ++rows;
+    }
+
+    // first pass: number of timesteps, second pass: the selected fields
+    PackedTrace P;
+    for (const char* c = rows; c < end; ++c) {
+        if (*c == '0' || *c == '1' || *c == ',') {
+            ++P.length;
+            while (c < end && *c != '\n') {
+                ++c;
+            }
+        }
+    }
+    P.num_vars = columns.size();
+    P.words = words_for(P.length);
+    P.columns.assign(P.num_vars * P.words, 0);
+
+    try {
+        size_t t = 0, line = 1;
+        for (const char* c = rows; c < end; ++line) {
+            const char* eol = (c < end) ? c + 1 : end;
+            while (eol < end && *eol != '\n') {
+                ++eol;
+            }
+            size_t field = 0, values = 0;
+            for (const char* v = c; v < eol; ++v) {
+                if (*v == ',') {
+                    ++field;
+                } else if (*v == '0' || *v == '1') {
+                    if (++values != field + 1 || field >= header.size()) {
+                        throw invalid_argument("Line " + to_string(line + 1) + " of " + path
+                                               + " does not have one value per column.");
+                    }
+                    if (*v == '1' && slot[field] != -1) {
+                        P.columns[slot[field] * P.words + t / 64] |= uint64_t(1) << (t % 64);
+                    }
+                } else if (*v != ' ' && *v != '\r' && *v != '\n') {
+                    throw invalid_argument("Unexpected character '" + string(1, *v) + "' on line "
+                                           + to_string(line + 1) + " of " + path + ".");
+                }
+            }
+            if (values > 0 || field > 0) {
+                if (values != header.size() || field + 1 != header.size()) {
+                    throw invalid_argument("Line " + to_string(line + 1) + " of " + path
+                                           + " does not have one value per column.");
+                }
+                ++t;
+            }
+            c = eol;
+        }
+    } catch (...) {
+        munmap(mapped, bytes);
+        throw;
+    }
+    munmap(mapped, bytes);
+    // a column asked for twice (e.g. as p1 and by name) was read once
+    for (size_t j = 0; j < columns.size(); ++j) {
+        if (slot[columns[j]] != (int) j) {
+            copy(P.column(slot[columns[j]]), P.column(slot[columns[j]]) + P.words, P.columns.begin() + j * P.words);
+        }
+    }
+    return P;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "compile_mltl.h"
+#include "packed_trace.h"
+#include "trace_set.h"
+
+using namespace std;
+
+/*
+ * Input: compiled MLTL formula CF
+ *        names of the columns of a trace source, empty if it has none
+ * Output: CF reading variables 0..k-1 only, where variable j is column
+ *         columns[j] of the source
+ * pK and aK read column K, a named signal reads the column of that name.
+ * Variables are numbered in order of first use in CF, so sources with the
+ * same signals in a different column order bind CF to the same formula.
+ * Throws invalid_argument if a named signal is not one of names.
+ */
+CompiledFormula bind_signals(const CompiledFormula& CF, const vector<string>& names, vector<size_t>& columns);
+
+/*
+ * Throws invalid_argument if CF reads a named signal, for trace sources
+ * whose variables have no names
+ */
+void check_no_signals(const CompiledFormula& CF);
+
+/*
+ * Returns true if path is a CSV file whose first line names its columns
+ * (e.g. "# a0,a1,a2" as R2U2 writes it, or "speed_ok,alt_ok"), or a
+ * trace-set file with signal names
+ */
+bool has_signal_names(const string& path);
+
+/*
+ * Column store over the traces of one file, read one column at a time:
+ * a CSV file with a header row holds one trace, a trace-set file holds many.
+ * Only the columns asked for are stored, so a formula over a few signals
+ * of a wide trace costs a few bit columns.
+ */
+class SignalStore {
+public:
+    explicit SignalStore(const string& path);
+
+    // column names in column order, empty for a trace set without names
+    const vector<string>& signals() const;
+    size_t size() const;
+    string name(size_t i) const;
+
+    // trace i with column j holding source column columns[j]
+    PackedTrace load(size_t i, const vector<size_t>& columns) const;
+
+private:
+    string path;
+    unique_ptr<TraceSet> set;  // null for a CSV file
+    vector<string> header;
+};
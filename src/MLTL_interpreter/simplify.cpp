@@ -0,0 +1,238 @@
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "simplify.h"
+
+using namespace std;
+
+FormulaStats formula_stats(const CompiledFormula& CF) {
+    FormulaStats stats;
+    stats.nodes = CF.nodes.size();
+    // weight of every node, summed over its parents; parents come after
+    // their operands, so walking down from the root sees each parent first
+    vector<double> weight(CF.nodes.size(), 0);
+    weight[CF.root] = 1;
+    for (int i = CF.root; i >= 0; --i) {
+        const MLTLNode& n = CF.nodes[i];
+        stats.cost += weight[i];
+        double below = weight[i] * (is_temporal(n.op) ? n.ub - n.lb + 1 : 1);
+        if (n.left != -1) {
+            weight[n.left] += below;
+        }
+        if (n.right != -1) {
+            weight[n.right] += below;
+        }
+    }
+    return stats;
+}
+
+typedef tuple<MLTLOp, int, int, int, int, int> NodeKey;
+
+/*
+ * Rebuilds a formula bottom-up, simplifying each node once its operands are
+ */
+class Simplifier {
+public:
+    explicit Simplifier(bool share) : share(share) {}
+
+    CompiledFormula run(const CompiledFormula& CF) {
+        vector<int> ids(CF.nodes.size());
+        for (int i = 0; i < CF.nodes.size(); ++i) {
+            MLTLNode n = CF.nodes[i];
+            if (n.left != -1) {
+                n.left = ids[n.left];
+            }
+            if (n.right != -1) {
+                n.right = ids[n.right];
+            }
+            ids[i] = make(n);
+        }
+        out.root = ids[CF.root];
+        out.signals = CF.signals;
+        return compact();
+    }
+
+private:
+    int constant(bool value) {
+        MLTLNode n;
+        n.op = value ? MLTLOp::TRUE_CONS : MLTLOp::FALSE_CONS;
+        return make(n);
+    }
+
+    int unary(MLTLOp op, int operand, int lb = 0, int ub = 0) {
+        MLTLNode n;
+        n.op = op;
+        n.lb = lb;
+        n.ub = ub;
+        n.left = operand;
+        return make(n);
+    }
+
+    MLTLOp op(int i) const {
+        return out.nodes[i].op;
+    }
+
+    bool equal(int a, int b) const {
+        return a == b || (!share && formula_to_string(out, a) == formula_to_string(out, b));
+    }
+
+    /*
+     * Returns the index of a node equivalent to n, whose operands are
+     * already simplified nodes of out
+     */
+    int make(const MLTLNode& n) {
+        const int l = n.left, r = n.right;
+        const int a = n.lb, b = n.ub;
+        switch (n.op) {
+        case MLTLOp::NOT:
+            if (op(l) == MLTLOp::NOT) {
+                return out.nodes[l].left;
+            }
+            if (op(l) == MLTLOp::TRUE_CONS || op(l) == MLTLOp::FALSE_CONS) {
+                return constant(op(l) == MLTLOp::FALSE_CONS);
+            }
+            break;
+        case MLTLOp::AND:
+            if (op(l) == MLTLOp::FALSE_CONS || op(r) == MLTLOp::TRUE_CONS || equal(l, r)) {
+                return l;
+            }
+            if (op(r) == MLTLOp::FALSE_CONS || op(l) == MLTLOp::TRUE_CONS) {
+                return r;
+            }
+            break;
+        case MLTLOp::OR:
+            if (op(l) == MLTLOp::TRUE_CONS || op(r) == MLTLOp::FALSE_CONS || equal(l, r)) {
+                return l;
+            }
+            if (op(r) == MLTLOp::TRUE_CONS || op(l) == MLTLOp::FALSE_CONS) {
+                return r;
+            }
+            break;
+        case MLTLOp::IMPLIES:
+            if (op(l) == MLTLOp::FALSE_CONS || op(r) == MLTLOp::TRUE_CONS || equal(l, r)) {
+                return constant(true);
+            }
+            if (op(l) == MLTLOp::TRUE_CONS) {
+                return r;
+            }
+            if (op(r) == MLTLOp::FALSE_CONS) {
+                return unary(MLTLOp::NOT, l);
+            }
+            break;
+        // F[a,b]true is not constant, it is false within a of the end
+        case MLTLOp::FINALLY:
+            if (op(l) == MLTLOp::FALSE_CONS) {
+                return l;
+            }
+            if (op(l) == MLTLOp::FINALLY) {
+                const MLTLNode& inner = out.nodes[l];
+                return unary(MLTLOp::FINALLY, inner.left, a + inner.lb, b + inner.ub);
+            }
+            break;
+        case MLTLOp::GLOBALLY:
+            if (op(l) == MLTLOp::TRUE_CONS) {
+                return l;
+            }
+            if (op(l) == MLTLOp::GLOBALLY && out.nodes[l].lb < out.nodes[l].ub) {
+                const MLTLNode& inner = out.nodes[l];
+                return unary(MLTLOp::GLOBALLY, inner.left, a + inner.lb, b + inner.ub);
+            }
+            break;
+        // the first F2 in the window has to be at q+a unless F1 is true
+        case MLTLOp::UNTIL:
+            if (op(r) == MLTLOp::FALSE_CONS) {
+                return r;
+            }
+            if (op(l) == MLTLOp::TRUE_CONS) {
+                return unary(MLTLOp::FINALLY, r, a, b);
+            }
+            if (op(l) == MLTLOp::FALSE_CONS || op(r) == MLTLOp::TRUE_CONS || equal(l, r)) {
+                return unary(MLTLOp::FINALLY, r, a, a);
+            }
+            break;
+        // the first !F2 in the window has to be past q+a unless F1 is false
+        case MLTLOp::RELEASE:
+            if (op(r) == MLTLOp::TRUE_CONS) {
+                return r;
+            }
+            if (op(l) == MLTLOp::TRUE_CONS || op(r) == MLTLOp::FALSE_CONS || equal(l, r)) {
+                return unary(MLTLOp::GLOBALLY, r, a, a);
+            }
+            break;
+        default:
+            break;
+        }
+        return intern(n);
+    }
+
+    /*
+     * Appends n to out, or with share returns the equal node already there
+     */
+    int intern(MLTLNode n) {
+        if (!share) {
+            out.nodes.push_back(n);
+            return out.nodes.size() - 1;
+        }
+        if ((n.op == MLTLOp::AND || n.op == MLTLOp::OR) && n.right < n.left) {
+            swap(n.left, n.right);
+        }
+        NodeKey key(n.op, n.var, n.lb, n.ub, n.left, n.right);
+        auto it = index.find(key);
+        if (it == index.end()) {
+            it = index.emplace(key, out.nodes.size()).first;
+            out.nodes.push_back(n);
+        }
+        return it->second;
+    }
+
+    /*
+     * Drops the nodes the root no longer reaches, such as the operands of
+     * folded nodes, keeping operands before their parents
+     */
+    CompiledFormula compact() {
+        vector<char> used(out.nodes.size(), 0);
+        used[out.root] = 1;
+        for (int i = out.root; i >= 0; --i) {
+            if (used[i] && out.nodes[i].left != -1) {
+                used[out.nodes[i].left] = 1;
+            }
+            if (used[i] && out.nodes[i].right != -1) {
+                used[out.nodes[i].right] = 1;
+            }
+        }
+        CompiledFormula result;
+        vector<int> ids(out.nodes.size(), -1);
+        for (int i = 0; i <= out.root; ++i) {
+            if (!used[i]) {
+                continue;
+            }
+            MLTLNode n = out.nodes[i];
+            if (n.left != -1) {
+                n.left = ids[n.left];
+            }
+            if (n.right != -1) {
+                n.right = ids[n.right];
+            }
+            ids[i] = result.nodes.size();
+            result.nodes.push_back(n);
+        }
+        result.root = ids[out.root];
+        result.signals = out.signals;
+        return result;
+    }
+
+    bool share;
+    CompiledFormula out;
+    map<NodeKey, int> index;
+};
+
+CompiledFormula simplify(const CompiledFormula& CF, bool share) {
+    return Simplifier(share).run(CF);
+}
+
+string simplify_report(const CompiledFormula& before, const CompiledFormula& after) {
+    FormulaStats b = formula_stats(before), a = formula_stats(after);
+    return "nodes " + to_string(b.nodes) + " -> " + to_string(a.nodes) + ", cost " + to_string((long long) b.cost) +
+           " -> " + to_string((long long) a.cost);
+}
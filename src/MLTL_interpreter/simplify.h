@@ -0,0 +1,45 @@
+#pragma once
+#include <string>
+#include "compile_mltl.h"
+
+using namespace std;
+
+/*
+ * Size and estimated evaluation cost of a compiled formula.
+ * nodes counts every stored node once, so shared subformulas count once.
+ * cost estimates the work of the recursive evaluator per timestep: every
+ * node weighs the product of the window widths (ub - lb + 1) of the
+ * temporal operators above it, summed over every path from the root.
+ */
+struct FormulaStats {
+    size_t nodes = 0;
+    double cost = 0;
+};
+
+FormulaStats formula_stats(const CompiledFormula& CF);
+
+/*
+ * Input: compiled MLTL formula CF
+ *        whether equal subformulas may share one node
+ * Output: a formula with the same verdict as CF on every trace, rewritten by
+ *   - constant folding: !true, p & false, p | true, F[a,b]false, ...
+ *   - double negation: !!p -> p
+ *   - interval merging: F[a,b]F[c,d]p -> F[a+c,b+d]p, and
+ *     G[a,b]G[c,d]p -> G[a+c,b+d]p when c < d
+ *   - U and R with a constant or repeated operand: true U[a,b] p -> F[a,b]p,
+ *     false U[a,b] p -> F[a,a]p, true R[a,b] p -> G[a,a]p, ...
+ *   - idempotence: p & p -> p, p | p -> p
+ * Operands of every node are simplified before the node itself. With
+ * share, structurally equal subformulas become a single node used by all
+ * their parents, so the bottom-up engines evaluate them once. The stream
+ * monitor needs one parent per node and simplifies without sharing.
+ * G[a,b]G[c,c] and false R[a,b] p are left alone: G also checks the empty
+ * suffix at the end of the trace, which the nested form never reaches.
+ */
+CompiledFormula simplify(const CompiledFormula& CF, bool share = true);
+
+/*
+ * One line comparing the stats of a formula before and after simplify(),
+ * e.g. "nodes 9 -> 5, cost 1234 -> 56"
+ */
+string simplify_report(const CompiledFormula& before, const CompiledFormula& after);
@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <stdexcept>
+#include "stream_monitor.h"
+#include "evaluate_dp.h"
+#include "utils.h"
+
+using namespace std;
+
+size_t future_reach(const CompiledFormula& CF, int i) {
+    const MLTLNode& n = CF.nodes[i];
+    size_t reach = 0;
+    if (n.left != -1) {
+        reach = future_reach(CF, n.left);
+    }
+    if (n.right != -1) {
+        reach = max(reach, future_reach(CF, n.right));
+    }
+    if (is_temporal(n.op)) {
+        reach += n.ub;
+    }
+    return reach;
+}
+
+StreamMonitor::StreamMonitor(const CompiledFormula& CF) : formula(CF), state(CF.nodes.size()) {}
+
+size_t StreamMonitor::length() const {
+    return count;
+}
+
+/*
+ * Returns the first position in [from, until) where operand has value,
+ * or a position >= until if there is none yet. cursor remembers how far
+ * the operand has been searched, every position in [from, cursor) has been
+ * seen not to match, so each position is looked at once per cursor.
+ */
+size_t StreamMonitor::seek(int operand, size_t& cursor, size_t from, size_t until, char value) {
+    const NodeState& S = state[operand];
+    cursor = max(cursor, from);
+    while (cursor < until && S.at(cursor) != value) {
+        ++cursor;
+    }
+    return cursor;
+}
+
+/*
+ * Drops the values of node i before position from
+ */
+void StreamMonitor::trim(int i, size_t from) {
+    NodeState& S = state[i];
+    while (S.base < from && !S.values.empty()) {
+        S.values.pop_front();
+        ++S.base;
+    }
+}
+
+/*
+ * Tries to decide the value of node i at position q from what its operands
+ * have decided so far. Every value decided here holds however the trace
+ * continues, including when it ends right after the timesteps read so far.
+ */
+bool StreamMonitor::step(int i, size_t q, char& value) {
+    const MLTLNode& n = formula.nodes[i];
+    NodeState& S = state[i];
+    const size_t s = q + n.lb, last = q + n.ub;
+    switch (n.op) {
+    case MLTLOp::TRUE_CONS:
+    case MLTLOp::FALSE_CONS:
+        value = (n.op == MLTLOp::TRUE_CONS);
+        return q < count;
+
+    case MLTLOp::PROP_VAR: {
+        if (q >= count) {
+            return false;
+        }
+        const string& row = pending_rows[q - reported];
+        if (n.var >= row.length()) {
+            throw invalid_argument("Propositional variable p" + to_string(n.var) + " is out of bounds of the trace.");
+        }
+        value = (row[n.var] != '0');
+        return true;
+    }
+
+    case MLTLOp::NOT:
+        if (state[n.left].decided() <= q) {
+            return false;
+        }
+        value = !state[n.left].at(q);
+        return true;
+
+    // decided by either operand alone when it is the absorbing value
+    case MLTLOp::AND:
+    case MLTLOp::OR:
+    case MLTLOp::IMPLIES: {
+        const NodeState& L = state[n.left];
+        const NodeState& R = state[n.right];
+        const bool l_known = L.decided() > q, r_known = R.decided() > q;
+        const char l = l_known ? L.at(q) : 0, r = r_known ? R.at(q) : 0;
+        if (n.op == MLTLOp::AND) {
+            if ((l_known && !l) || (r_known && !r)) {
+                value = false;
+                return true;
+            }
+            value = true;
+        } else if (n.op == MLTLOp::OR) {
+            if ((l_known && l) || (r_known && r)) {
+                value = true;
+                return true;
+            }
+            value = false;
+        } else {
+            if ((l_known && !l) || (r_known && r)) {
+                value = true;
+                return true;
+            }
+            value = false;
+        }
+        return l_known && r_known;
+    }
+
+    // true at the first subF in [q+a, q+b], false once the window is past
+    case MLTLOp::FINALLY: {
+        const size_t K = state[n.left].decided();
+        size_t r = seek(n.left, S.cursor[0], s, K, 1);
+        if (r < K) {
+            value = (r <= last);
+            return true;
+        }
+        value = false;
+        return K > last;
+    }
+
+    // false at the first !subF in [q+a, q+b], true once the window is past
+    case MLTLOp::GLOBALLY: {
+        const size_t K = state[n.left].decided();
+        size_t f = seek(n.left, S.cursor[0], s, K, 0);
+        if (f < K) {
+            value = (f > last);
+            return true;
+        }
+        value = true;
+        return K > last;
+    }
+
+    // the first F2 from q+a must come in the window, before any !F1
+    case MLTLOp::UNTIL: {
+        const size_t K = min(state[n.left].decided(), state[n.right].decided());
+        size_t r = seek(n.right, S.cursor[1], s, K, 1);
+        size_t l = seek(n.left, S.cursor[0], s, K, 0);
+        if (r < K) {
+            value = (r <= last && l >= r);
+            return true;
+        }
+        value = false;
+        return l < K || K > last;
+    }
+
+    // no !F2 in the window, or an F1 before the first one
+    case MLTLOp::RELEASE: {
+        const size_t K = min(state[n.left].decided(), state[n.right].decided());
+        size_t k = seek(n.right, S.cursor[1], s, K, 0);
+        size_t m = seek(n.left, S.cursor[0], s, K, 1);
+        if (k < K) {
+            value = (k > last || m < k);
+            return true;
+        }
+        value = true;
+        return m < K || K > last;
+    }
+    }
+    return false;
+}
+
+/*
+ * Decides as many positions of node i as possible, then drops the operand
+ * values node i will not look at again
+ */
+void StreamMonitor::advance(int i) {
+    const MLTLNode& n = formula.nodes[i];
+    NodeState& S = state[i];
+    char value;
+    while (step(i, S.decided(), value)) {
+        S.values.push_back(value);
+    }
+    const size_t from = S.decided() + (is_temporal(n.op) ? n.lb : 0);
+    if (n.left != -1) {
+        trim(n.left, from);
+    }
+    if (n.right != -1) {
+        trim(n.right, from);
+    }
+}
+
+void StreamMonitor::push(const string& row, vector<bool>& verdicts) {
+    pending_rows.push_back(strip_char(strip_char(row, ' '), ','));
+    ++count;
+    for (int i = 0; i < formula.nodes.size(); ++i) {
+        advance(i);
+    }
+    NodeState& root = state[formula.root];
+    for (char v : root.values) {
+        verdicts.push_back(v);
+    }
+    trim(formula.root, root.decided());
+    while (reported < root.decided()) {
+        pending_rows.pop_front();
+        ++reported;
+    }
+}
+
+void StreamMonitor::finish(vector<bool>& verdicts) {
+    // the verdict at t only depends on T[t:], so the undecided positions
+    // are those of the remaining rows evaluated as a trace on their own
+    vector<string> rest(pending_rows.begin(), pending_rows.end());
+    TruthVector root = truth_vectors(formula, rest)[formula.root];
+    for (size_t t = 0; t < rest.size(); ++t) {
+        verdicts.push_back(root[t]);
+    }
+    reported += rest.size();
+    pending_rows.clear();
+}
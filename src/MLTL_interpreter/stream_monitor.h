@@ -0,0 +1,68 @@
+#pragma once
+#include <deque>
+#include <string>
+#include <vector>
+#include "compile_mltl.h"
+
+using namespace std;
+
+/*
+ * Number of timesteps past t that the verdict of node i at t can depend on:
+ * once the trace reaches t + future_reach, the verdict at t is fixed no
+ * matter how the trace continues.
+ */
+size_t future_reach(const CompiledFormula& CF, int i);
+
+/*
+ * Online monitor over a trace read one timestep at a time.
+ * The verdict at position t is the verdict of the formula on the suffix
+ * T[t:] of the whole trace, the same as evaluate() gives on that suffix.
+ * Verdicts are emitted in position order, each as soon as the timesteps
+ * seen so far decide it and at the latest future_reach timesteps later.
+ * Every subformula only keeps the values its parent can still look at,
+ * so memory is O(|CF| * future_reach) whatever the length of the trace,
+ * and each timestep costs amortized O(|CF|).
+ */
+class StreamMonitor {
+public:
+    explicit StreamMonitor(const CompiledFormula& CF);
+
+    /*
+     * Feeds the next timestep and appends every verdict it decides to
+     * verdicts. ' ' and ',' in row are ignored.
+     */
+    void push(const string& row, vector<bool>& verdicts);
+
+    /*
+     * Ends the trace and appends the verdicts of all remaining positions
+     */
+    void finish(vector<bool>& verdicts);
+
+    /*
+     * Number of timesteps read so far
+     */
+    size_t length() const;
+
+private:
+    // values of one node for the positions [base, base + values.size())
+    struct NodeState {
+        deque<char> values;
+        size_t base = 0;
+        // seek cursors into the operands, see seek()
+        size_t cursor[2] = {0, 0};
+        size_t decided() const { return base + values.size(); }
+        char at(size_t t) const { return values[t - base]; }
+    };
+
+    bool step(int i, size_t q, char& value);
+    size_t seek(int operand, size_t& cursor, size_t from, size_t until, char value);
+    void trim(int i, size_t from);
+    void advance(int i);
+
+    CompiledFormula formula;
+    vector<NodeState> state;
+    size_t count = 0;
+    // timesteps from the first undecided position on, for finish()
+    deque<string> pending_rows;
+    size_t reported = 0;
+};
@@ -0,0 +1,104 @@
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "summary_file.h"
+
+using namespace std;
+
+/*
+ * Packs the trace in [begin, end), a single line without its newline
+ */
+static PackedTrace parse_trace(const char* begin, const char* end, size_t line) {
+    // first pass: length and width, second pass: the bits
+    PackedTrace P;
+    size_t width = 0;
+    bool in_step = false;
+    for (const char* c = begin; c < end; ++c) {
+        if (*c == '0' || *c == '1') {
+            if (!in_step) {
+                ++P.length;
+                in_step = true;
+            }
+            if (P.length == 1) {
+                ++width;
+            }
+        } else if (*c == ',') {
+            in_step = false;
+        } else if (*c != ' ' && *c != '\r') {
+            throw invalid_argument("Unexpected character '" + string(1, *c) + "' on line "
+                                   + to_string(line + 1) + ".");
+        }
+    }
+    P.num_vars = width;
+    P.words = words_for(P.length);
+    P.columns.assign(P.num_vars * P.words, 0);
+
+    size_t t = 0, p = 0;
+    in_step = false;
+    for (const char* c = begin; c < end; ++c) {
+        if (*c == ',') {
+            if (in_step && p != width) {
+                throw invalid_argument("Timesteps of different widths on line " + to_string(line + 1) + ".");
+            }
+            t += in_step;
+            p = 0;
+            in_step = false;
+        } else if (*c == '0' || *c == '1') {
+            in_step = true;
+            if (p == width) {
+                throw invalid_argument("Timesteps of different widths on line " + to_string(line + 1) + ".");
+            }
+            if (*c == '1') {
+                P.columns[p * P.words + t / 64] |= uint64_t(1) << (t % 64);
+            }
+            ++p;
+        }
+    }
+    if (in_step && p != width) {
+        throw invalid_argument("Timesteps of different widths on line " + to_string(line + 1) + ".");
+    }
+    return P;
+}
+
+vector<PackedTrace> read_summary_file(const string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw invalid_argument("Could not open " + path + ".");
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw invalid_argument("Could not read " + path + ".");
+    }
+    const size_t bytes = st.st_size;
+    vector<PackedTrace> traces;
+    if (bytes == 0) {
+        close(fd);
+        return traces;
+    }
+    void* mapped = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        throw invalid_argument("Could not map " + path + ".");
+    }
+
+    const char* data = (const char*) mapped;
+    const char* end = data + bytes;
+    try {
+        for (const char* line = data; line < end;) {
+            const char* eol = line;
+            while (eol < end && *eol != '\n') {
+                ++eol;
+            }
+            traces.push_back(parse_trace(line, eol, traces.size()));
+            line = eol + 1;
+        }
+    } catch (...) {
+        munmap(mapped, bytes);
+        throw;
+    }
+    munmap(mapped, bytes);
+    return traces;
+}
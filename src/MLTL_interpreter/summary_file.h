@@ -0,0 +1,17 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "packed_trace.h"
+
+using namespace std;
+
+/*
+ * Input: path of a file in the multiple traces format (one trace per line,
+ *        timesteps separated by commas, e.g. a dataset's pos_summary.txt)
+ * Output: every trace of the file, in line order, packed into bit columns
+ * The file is mapped and scanned once, without building strings.
+ * Spaces and '\r' are ignored; an empty line is an empty trace.
+ * Throws invalid_argument if a trace has timesteps of different widths
+ * or characters other than 0 and 1.
+ */
+vector<PackedTrace> read_summary_file(const string& path);
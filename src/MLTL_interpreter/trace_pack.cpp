@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "utils.h"
+#include "trace_set.h"
+#include "signal_store.h"
+
+using namespace std;
+
+// https://stackoverflow.com/questions/55474690/stdfilesystem-has-not-been-declared-after-including-experimental-filesystem
+#ifndef __has_include
+  static_assert(false, "__has_include not supported");
+#else
+#  if __cplusplus >= 201703L && __has_include(<filesystem>)
+#    include <filesystem>
+     namespace fs = std::filesystem;
+#  elif __has_include(<experimental/filesystem>)
+#    include <experimental/filesystem>
+     namespace fs = std::experimental::filesystem;
+#  elif __has_include(<boost/filesystem.hpp>)
+#    include <boost/filesystem.hpp>
+     namespace fs = boost::filesystem;
+#  endif
+#endif
+
+int main(int argc, char** argv) {
+    // should be 2 arguments: dataset directory, output file
+    // A dataset directory holds the trace directories pos_train, neg_train,
+    // pos_test and neg_test; traces are stored as "<directory>/<file name>".
+    // Any other directory is packed as a single flat batch of traces.
+    if (argc != 3) {
+        throw invalid_argument("Incorrect number of arguments.");
+    }
+    string dataset_dir = argv[1];
+    string output_file = argv[2];
+
+    const vector<string> groups = {"pos_train", "neg_train", "pos_test", "neg_test"};
+    vector<NamedTrace> traces;
+    // CSV traces with a header row must all name the same columns, the
+    // names are stored once as the signal names of the set
+    vector<string> signals;
+    size_t named = 0;
+    auto take_header = [&](NamedTrace& nt) {
+        if (!has_signal_names(nt.name)) {
+            return;
+        }
+        vector<string> names = SignalStore(nt.name).signals();
+        if (named > 0 && names != signals) {
+            throw invalid_argument("Trace " + nt.name + " names its columns differently.");
+        }
+        signals = names;
+        ++named;
+        nt.trace.erase(nt.trace.begin());
+    };
+    bool found_group = false;
+    for (const string& group : groups) {
+        fs::path dir = fs::path(dataset_dir) / group;
+        if (!fs::is_directory(dir)) {
+            continue;
+        }
+        found_group = true;
+        for (NamedTrace& nt : read_batch_from_file(dir.string())) {
+            take_header(nt);
+            nt.name = group + "/" + fs::path(nt.name).filename().string();
+            traces.push_back(nt);
+        }
+    }
+    if (!found_group) {
+        for (NamedTrace& nt : read_batch_from_file(dataset_dir)) {
+            take_header(nt);
+            nt.name = fs::path(nt.name).filename().string();
+            traces.push_back(nt);
+        }
+    }
+    // directory order is arbitrary, store traces sorted by name
+    sort(traces.begin(), traces.end(), [](const NamedTrace& a, const NamedTrace& b) {
+        return a.name < b.name;
+    });
+
+    if (named > 0 && named != traces.size()) {
+        throw invalid_argument("Either every trace or none must have a header row.");
+    }
+
+    write_trace_set(output_file, traces, signals);
+    cout << "Packed " << traces.size() << " traces into " << output_file << endl;
+    return 0;
+}
@@ -0,0 +1,245 @@
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "trace_set.h"
+
+using namespace std;
+
+static uint64_t align8(uint64_t x) {
+    return (x + 7) & ~uint64_t(7);
+}
+
+void write_trace_set(const string& path, const vector<NamedTrace>& traces,
+                     const vector<string>& signals) {
+    // strip the rows and find the width shared by every timestep
+    vector<vector<string>> rows(traces.size());
+    bool have_width = false;
+    size_t num_vars = 0;
+    for (size_t i = 0; i < traces.size(); ++i) {
+        for (const string& line : traces[i].trace) {
+            string row = strip_char(strip_char(line, ' '), ',');
+            if (!have_width) {
+                num_vars = row.length();
+                have_width = true;
+            } else if (row.length() != num_vars) {
+                throw invalid_argument("Trace " + traces[i].name + " has rows of different widths.");
+            }
+            rows[i].push_back(row);
+        }
+    }
+    string signal_names;
+    if (!signals.empty()) {
+        if (have_width && signals.size() != num_vars) {
+            throw invalid_argument("Expected " + to_string(num_vars) + " signal names, got "
+                                   + to_string(signals.size()) + ".");
+        }
+        num_vars = signals.size();
+        for (const string& name : signals) {
+            if (name.empty() || name.find('\n') != string::npos) {
+                throw invalid_argument("Invalid signal name '" + name + "'.");
+            }
+            signal_names += name + "\n";
+        }
+    }
+    const uint64_t row_bytes = (num_vars + 7) / 8;
+
+    TraceSetHeader header;
+    memcpy(header.magic, TRACE_SET_MAGIC, 4);
+    header.version = signals.empty() ? 1 : TRACE_SET_VERSION;
+    header.num_traces = traces.size();
+    header.num_vars = num_vars;
+    header.row_bytes = row_bytes;
+
+    // lay out the index, the names, then the rows of each trace
+    const uint64_t index_offset = sizeof(TraceSetHeader) + (signals.empty() ? 0 : sizeof(TraceSetSignals));
+    vector<TraceSetEntry> entries(traces.size());
+    uint64_t offset = index_offset + traces.size() * sizeof(TraceSetEntry);
+    for (size_t i = 0; i < traces.size(); ++i) {
+        entries[i].name_offset = offset;
+        entries[i].name_length = traces[i].name.length();
+        entries[i].length = rows[i].size();
+        offset += traces[i].name.length();
+    }
+    TraceSetSignals signals_block = {offset, signal_names.length()};
+    offset += signal_names.length();
+    for (size_t i = 0; i < traces.size(); ++i) {
+        offset = align8(offset);
+        entries[i].rows_offset = offset;
+        offset += rows[i].size() * row_bytes;
+    }
+
+    vector<char> file(align8(offset), 0);
+    memcpy(file.data(), &header, sizeof(header));
+    if (!signals.empty()) {
+        memcpy(file.data() + sizeof(header), &signals_block, sizeof(signals_block));
+        memcpy(file.data() + signals_block.names_offset, signal_names.data(), signal_names.length());
+    }
+    memcpy(file.data() + index_offset, entries.data(), entries.size() * sizeof(TraceSetEntry));
+    for (size_t i = 0; i < traces.size(); ++i) {
+        memcpy(file.data() + entries[i].name_offset, traces[i].name.data(), traces[i].name.length());
+        unsigned char* out = (unsigned char*) file.data() + entries[i].rows_offset;
+        for (size_t t = 0; t < rows[i].size(); ++t) {
+            for (size_t p = 0; p < num_vars; ++p) {
+                if (rows[i][t][p] != '0') {
+                    out[t * row_bytes + p / 8] |= 1 << (p % 8);
+                }
+            }
+        }
+    }
+
+    ofstream out(path, ios::binary);
+    if (!out) {
+        throw invalid_argument("Could not open " + path + " for writing.");
+    }
+    out.write(file.data(), file.size());
+}
+
+TraceSet::TraceSet(const string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw invalid_argument("Could not open trace set " + path + ".");
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(TraceSetHeader)) {
+        close(fd);
+        throw invalid_argument(path + " is not a trace set.");
+    }
+    bytes = st.st_size;
+    void* mapped = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        throw invalid_argument("Could not map trace set " + path + ".");
+    }
+    data = (const unsigned char*) mapped;
+    header = (const TraceSetHeader*) data;
+
+    // check everything the accessors rely on once, up front
+    bool valid = memcmp(header->magic, TRACE_SET_MAGIC, 4) == 0
+                 && (header->version == 1 || header->version == TRACE_SET_VERSION)
+                 && header->row_bytes == (header->num_vars + 7) / 8;
+    size_t index_offset = sizeof(TraceSetHeader);
+    const TraceSetSignals* signals_block = nullptr;
+    if (valid && header->version >= 2) {
+        index_offset += sizeof(TraceSetSignals);
+        signals_block = (const TraceSetSignals*) (data + sizeof(TraceSetHeader));
+        valid = bytes >= index_offset
+                && signals_block->names_offset <= bytes
+                && signals_block->names_length <= bytes - signals_block->names_offset;
+    }
+    entries = (const TraceSetEntry*) (data + index_offset);
+    valid = valid && header->num_traces <= (bytes - index_offset) / sizeof(TraceSetEntry);
+    for (size_t i = 0; valid && i < header->num_traces; ++i) {
+        const TraceSetEntry& e = entries[i];
+        valid = e.name_offset <= bytes && e.name_length <= bytes - e.name_offset
+                && e.rows_offset <= bytes
+                && (header->row_bytes == 0 || e.length <= (bytes - e.rows_offset) / header->row_bytes);
+    }
+    if (valid && signals_block != nullptr) {
+        const char* names = (const char*) data + signals_block->names_offset;
+        size_t begin = 0;
+        for (size_t i = 0; i < signals_block->names_length; ++i) {
+            if (names[i] == '\n') {
+                signal_names.push_back(string(names + begin, i - begin));
+                begin = i + 1;
+            }
+        }
+        valid = begin == signals_block->names_length && signal_names.size() == header->num_vars;
+    }
+    if (!valid) {
+        munmap((void*) data, bytes);
+        throw invalid_argument(path + " is not a valid trace set.");
+    }
+}
+
+TraceSet::~TraceSet() {
+    munmap((void*) data, bytes);
+}
+
+size_t TraceSet::size() const {
+    return header->num_traces;
+}
+
+size_t TraceSet::num_vars() const {
+    return header->num_vars;
+}
+
+string TraceSet::name(size_t i) const {
+    return string((const char*) data + entries[i].name_offset, entries[i].name_length);
+}
+
+size_t TraceSet::length(size_t i) const {
+    return entries[i].length;
+}
+
+const vector<string>& TraceSet::signals() const {
+    return signal_names;
+}
+
+bool TraceSet::get(size_t i, size_t t, size_t p) const {
+    const unsigned char* row = data + entries[i].rows_offset + t * header->row_bytes;
+    return (row[p / 8] >> (p % 8)) & 1;
+}
+
+vector<string> TraceSet::trace(size_t i) const {
+    vector<string> T(length(i), string(num_vars(), '0'));
+    for (size_t t = 0; t < T.size(); ++t) {
+        for (size_t p = 0; p < num_vars(); ++p) {
+            if (get(i, t, p)) {
+                T[t][p] = '1';
+            }
+        }
+    }
+    return T;
+}
+
+PackedTrace TraceSet::packed(size_t i, const vector<size_t>& columns) const {
+    PackedTrace P;
+    P.length = length(i);
+    P.num_vars = columns.size();
+    P.words = words_for(P.length);
+    P.columns.assign(P.num_vars * P.words, 0);
+    for (size_t j = 0; j < columns.size(); ++j) {
+        const size_t p = columns[j];
+        if (p >= num_vars() && P.length > 0) {
+            throw invalid_argument("Propositional variable p" + to_string(p) + " is out of bounds of the trace.");
+        }
+        // a column is one bit per row, gather it a row at a time
+        const unsigned char* row = data + entries[i].rows_offset + p / 8;
+        const int shift = p % 8;
+        uint64_t* col = P.columns.data() + j * P.words;
+        for (size_t t = 0; t < P.length; ++t, row += header->row_bytes) {
+            col[t / 64] |= uint64_t((*row >> shift) & 1) << (t % 64);
+        }
+    }
+    return P;
+}
+
+bool is_trace_set(const string& path) {
+    ifstream in(path, ios::binary);
+    char magic[4];
+    return in.read(magic, 4) && memcmp(magic, TRACE_SET_MAGIC, 4) == 0;
+}
+
+vector<NamedTrace> read_batch_from_trace_set(const TraceSet& S) {
+    vector<NamedTrace> batch(S.size());
+    for (size_t i = 0; i < S.size(); ++i) {
+        batch[i].name = S.name(i);
+        batch[i].trace = S.trace(i);
+    }
+    return batch;
+}
+
+vector<vector<string>> read_trace_set_group(const TraceSet& S, const string& group) {
+    const string prefix = group + "/";
+    vector<vector<string>> traces;
+    for (size_t i = 0; i < S.size(); ++i) {
+        if (S.name(i).compare(0, prefix.length(), prefix) == 0) {
+            traces.push_back(S.trace(i));
+        }
+    }
+    return traces;
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "utils.h"
+#include "packed_trace.h"
+
+using namespace std;
+
+/*
+ * Packed trace-set file, one file for a whole batch of traces.
+ * All integers are little-endian, all offsets are from the start of the file.
+ *
+ *   header   TraceSetHeader
+ *   signals  TraceSetSignals, version 2 only
+ *   index    num_traces x TraceSetEntry
+ *   names    concatenated trace names, not terminated
+ *   signal names, version 2 only: one name per variable, each followed by '\n'
+ *   rows     for each trace, `length` rows of row_bytes bytes each, starting
+ *            on an 8-byte boundary; variable p of a row is bit p % 8 of
+ *            byte p / 8
+ * Version 1 files have no signal names; they are still read.
+ */
+const char TRACE_SET_MAGIC[4] = {'M', 'L', 'T', 'S'};
+const uint32_t TRACE_SET_VERSION = 2;
+
+struct TraceSetHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t num_traces;
+    uint64_t num_vars;
+    uint64_t row_bytes;
+};
+
+struct TraceSetSignals {
+    uint64_t names_offset;
+    uint64_t names_length;
+};
+
+struct TraceSetEntry {
+    uint64_t name_offset;
+    uint64_t name_length;
+    uint64_t length;       // number of timesteps
+    uint64_t rows_offset;
+};
+
+/*
+ * Writes traces to a trace-set file at path. Every timestep of every trace
+ * must have the same number of variables; ' ' and ',' are ignored.
+ * signals names the variables in column order; without names the file is
+ * written as version 1.
+ */
+void write_trace_set(const string& path, const vector<NamedTrace>& traces,
+                     const vector<string>& signals = {});
+
+/*
+ * Read-only view of a trace-set file mapped into memory.
+ * Opening costs one open/mmap; the traces are only read when accessed.
+ */
+class TraceSet {
+public:
+    explicit TraceSet(const string& path);
+    ~TraceSet();
+    TraceSet(const TraceSet&) = delete;
+    TraceSet& operator=(const TraceSet&) = delete;
+
+    size_t size() const;
+    size_t num_vars() const;
+    string name(size_t i) const;
+    size_t length(size_t i) const;
+
+    // names of the variables in column order, empty if the file has none
+    const vector<string>& signals() const;
+
+    // value of variable p at timestep t of trace i
+    bool get(size_t i, size_t t, size_t p) const;
+
+    // trace i as rows of '0'/'1', the form the evaluators take
+    vector<string> trace(size_t i) const;
+
+    // only the given variables of trace i, column j of the result holding
+    // variable columns[j]; the other variables are never read
+    PackedTrace packed(size_t i, const vector<size_t>& columns) const;
+
+private:
+    const unsigned char* data = nullptr;
+    size_t bytes = 0;
+    const TraceSetHeader* header = nullptr;
+    const TraceSetEntry* entries = nullptr;
+    vector<string> signal_names;
+};
+
+/*
+ * Returns true if path names a trace-set file rather than a directory
+ */
+bool is_trace_set(const string& path);
+
+/*
+ * Every trace of S, in file order, named as stored
+ */
+vector<NamedTrace> read_batch_from_trace_set(const TraceSet& S);
+
+/*
+ * The traces of S whose name starts with "group/", in file order
+ * (e.g. group "pos_train" of a converted dataset)
+ */
+vector<vector<string>> read_trace_set_group(const TraceSet& S, const string& group);
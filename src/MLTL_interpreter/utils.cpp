@@ -34,7 +34,7 @@ using namespace std;
 string strip_char(string s, char c)
 {
 	string w = "";
-	for (int j = 0; j < s.length(); ++j) {
+	for (size_t j = 0; j < s.length(); ++j) {
 		if (s[j] != c) {
 			w += s[j];
 		}
@@ -47,12 +47,12 @@ string strip_char(string s, char c)
  * Prints each element of a vector of strings on a new line
  */
 void print(vector<string> v) {
-	for (int i = 0; i < v.size(); ++i) {
+	for (size_t i = 0; i < v.size(); ++i) {
 		cout << v[i] << endl;
 	}
 }
 void print(vector<int> v) {
-	for (int i = 0; i < v.size(); ++i) {
+	for (size_t i = 0; i < v.size(); ++i) {
 		cout << v[i] << endl;
 	}
 }
@@ -113,6 +113,24 @@ vector<string> read_from_file(string in) {
     return v;
 }
 
+/*
+Returns true if path names a directory
+*/
+bool is_directory(const string& path) {
+	return fs::is_directory(path);
+}
+
+/*
+Paths of the files in directory in, in arbitrary order
+*/
+vector<string> directory_files(const string& in) {
+	vector<string> files;
+	for (const auto & entry : fs::directory_iterator(in)) {
+		files.push_back(entry.path().string());
+	}
+	return files;
+}
+
 /*
 Read a batch of traces from a directory and return a vector of NamedTrace
 Run read_from_file on each file in the directory
@@ -142,7 +160,7 @@ vector<NamedTrace> read_batch_from_file(string in) {
 * Function to slice a given vector
 * from range X to Y
 */ 
-vector<string> slice(vector<string>& arr, int X, int Y)
+vector<string> slice(const vector<string>& arr, int X, int Y)
 {
  
     // Starting and Ending iterators
@@ -53,6 +53,16 @@ struct NamedTrace {
 	string name;
 	vector<string> trace;
 };
+/*
+Returns true if path names a directory
+*/
+bool is_directory(const string& path);
+
+/*
+Paths of the files in directory in, in arbitrary order
+*/
+vector<string> directory_files(const string& in);
+
 /*
 Read a batch of traces form a file and return a vector of vectors of strings
 */
@@ -63,4 +73,25 @@ vector<NamedTrace> read_batch_from_file(string in);
 * Function to slice a given vector
 * from range X to Y
 */ 
-vector<string> slice(vector<string>& arr, int X, int Y);
\ No newline at end of file
+vector<string> slice(const vector<string>& arr, int X, int Y);
+
+
+/*
+* Read-only (offset, length) window over a trace.
+* Taking a suffix only moves the offset, so nothing is copied.
+*/
+struct TraceView {
+	const vector<string>* trace;
+	size_t offset;
+	size_t length;
+
+	TraceView(const vector<string>& T) : trace(&T), offset(0), length(T.size()) {}
+	TraceView(const vector<string>& T, size_t offset, size_t length)
+		: trace(&T), offset(offset), length(length) {}
+
+	size_t size() const { return length; }
+	const string& operator[](size_t i) const { return (*trace)[offset + i]; }
+
+	// view of the suffix starting at timestep i, i <= size()
+	TraceView suffix(size_t i) const { return TraceView(*trace, offset + i, length - i); }
+};
\ No newline at end of file
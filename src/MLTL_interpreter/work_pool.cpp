@@ -0,0 +1,92 @@
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "work_pool.h"
+
+using namespace std;
+
+struct TaskQueue {
+    mutex lock;
+    deque<size_t> tasks;
+};
+
+int hardware_threads() {
+    int n = thread::hardware_concurrency();
+    return (n > 0) ? n : 1;
+}
+
+/*
+ * Takes the next task of worker w, from its own queue or stolen from
+ * another one. Returns false once every queue is empty.
+ */
+static bool next_task(vector<TaskQueue>& queues, size_t w, size_t& task) {
+    {
+        lock_guard<mutex> guard(queues[w].lock);
+        if (!queues[w].tasks.empty()) {
+            task = queues[w].tasks.front();
+            queues[w].tasks.pop_front();
+            return true;
+        }
+    }
+    for (size_t k = 1; k < queues.size(); ++k) {
+        TaskQueue& victim = queues[(w + k) % queues.size()];
+        lock_guard<mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.back();
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void parallel_for(size_t n, int threads, const function<void(size_t)>& body) {
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (threads == 1 || n <= 1) {
+        for (size_t i = 0; i < n; ++i) {
+            body(i);
+        }
+        return;
+    }
+    if (n < threads) {
+        threads = n;
+    }
+
+    // tasks never get added once workers run, so an empty sweep over all
+    // queues means there is nothing left to do
+    vector<TaskQueue> queues(threads);
+    for (size_t i = 0; i < n; ++i) {
+        queues[i % threads].tasks.push_back(i);
+    }
+    atomic<bool> failed(false);
+    exception_ptr error;
+    mutex error_lock;
+    vector<thread> workers;
+    for (int w = 0; w < threads; ++w) {
+        workers.emplace_back([&, w]() {
+            size_t task;
+            while (!failed && next_task(queues, w, task)) {
+                try {
+                    body(task);
+                } catch (...) {
+                    lock_guard<mutex> guard(error_lock);
+                    if (!error) {
+                        error = current_exception();
+                    }
+                    failed = true;
+                }
+            }
+        });
+    }
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    if (error) {
+        rethrow_exception(error);
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+
+using namespace std;
+
+/*
+ * Number of worker threads to use for -j 0, at least 1
+ */
+int hardware_threads();
+
+/*
+ * Input: number of tasks n
+ *        number of worker threads
+ *        body, called once for every task index in [0, n)
+ * Tasks are dealt round-robin onto one deque per worker, so callers should
+ * list expensive tasks first. Each worker takes tasks from the front of its
+ * own deque and, once that is empty, steals from the back of another one,
+ * so no thread idles while work is left. body must be safe to call
+ * concurrently for different indices. The first exception thrown by body
+ * is rethrown once all workers have stopped.
+ */
+void parallel_for(size_t n, int threads, const function<void(size_t)>& body);
@@ -11,6 +11,8 @@
 #include "reg.h"
 #include "utils.h"
 #include "parser.h"
+#include "compile_mltl.h"
+#include "simplify.h"
 
 using namespace std;
 
@@ -51,6 +53,17 @@ int main(int argc, char** argv) {
 	}
     wff = strip_char(wff, ' ');
 
+    // simplify with the interpreter's rewriting pass before converting to nnf,
+    // formulas it cannot parse (= and the associative connectives) are kept as is
+    try {
+        CompiledFormula parsed = compile_mltl(wff);
+        CompiledFormula simplified = simplify(parsed, false);
+        wff = formula_to_string(simplified);
+        cout << "\tsimplified: " << wff << " (" << simplify_report(parsed, simplified) << ")" << endl;
+    } catch (const invalid_argument& e) {
+        cout << "\tnot simplified: " << e.what() << endl;
+    }
+
     bool optimized = false;
     if (argc == 3 && string(argv[2]) == "-OPTIMIZED") {
         optimized = true;
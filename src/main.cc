@@ -51,51 +51,8 @@ public:
 float h_dist(const NodeWrapper &node) { return abs(node.accuracy - 0.5); }
 float h_size(const NodeWrapper &node) { return node.size; }
 
-/*
-bool best_first_search(vector<unique_ptr<ASTNode>> &bool_funcs, int *numNodes,
-                       function<float(const NodeWrapper &)> h = nullptr) {
-  *numNodes = 0;
-  set<NodeWrapper> visited;
-  set<NodeWrapper> pq;
-  // visited.emplace(p);
-  // pq.emplace(p);
-
-  while (!pq.empty()) {
-    const NodeWrapper &p = *pq.begin();
-    pq.erase(p);
-
-    // generate adjacent formulas
-    vector<unique_ptr<ASTNode>> adj_list;
-
-    // for (int i = 0; i < num_adj; ++i) {
-    //   // p.priority = h(p);
-    //   auto reached = visited.find(adj_buf[i]);
-    //   if (reached == visited.end()) {
-    //     // first time we have seen this node
-    //     *numNodes += 1;
-    //     adj_buf[i].set_pred(p);
-    //     visited.emplace(p);
-    //     pq.emplace(adj_buf[i]);
-    //   } else if (adj_buf[i].path_cost < reached->path_cost) {
-    //     pq.erase(*reached);
-    //     adj_buf[i].set_pred(p);
-    //     pq.emplace(std::move(new_ast), priority, accuracy);
-    // }
-
-      if (p.accuracy == 1) {
-        return true;
-      }
-      if (p.accuracy == 0) {
-        cout << p.ast->as_pretty_string();
-        return true; // but negate it
-      }
-    }
-  }
-
-  cout << "No solutions exist.\n";
-  return false;
-}
-*/
+// best_first_search() lives in search/src/best_first.hh, run it with
+// search --best-first [--heuristic dist|size|astar]
 
 void replaceVar(ASTNode &ast, unsigned int id, unsigned int new_id) {
   if (ast.get_type() == ASTNode::Type::Variable) {
@@ -0,0 +1,184 @@
+#include "best_first.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <unordered_set>
+
+using namespace std;
+using namespace libmltl;
+
+bool SearchNode::operator<(const SearchNode &rhs) const {
+  if (priority != rhs.priority) {
+    return priority < rhs.priority;
+  }
+  if (size != rhs.size) {
+    return size < rhs.size;
+  }
+  return sequence < rhs.sequence;
+}
+
+static float h_dist(const SearchNode &node) {
+  return 0.5f - abs(node.accuracy - 0.5f);
+}
+static float h_size(const SearchNode &node) { return node.size; }
+
+Heuristic make_heuristic(const string &name, float weight) {
+  if (name == "dist") {
+    return h_dist;
+  }
+  if (name == "size") {
+    return h_size;
+  }
+  if (name == "astar") {
+    return [weight](const SearchNode &node) {
+      return h_size(node) + weight * 2 * h_dist(node);
+    };
+  }
+  return Heuristic();
+}
+
+class BestFirst {
+public:
+  BestFirst(SignatureScorer &train, const vector<shared_ptr<ASTNode>> &atoms,
+            const Heuristic &h, const BestFirstOptions &options,
+            BestFirstStats &stats)
+      : train(train), atoms(atoms), h(h), options(options), stats(stats) {}
+
+  SearchNode run() {
+    vector<shared_ptr<ASTNode>> candidates(atoms);
+    bool found = offer(candidates);
+    while (!found && !queue.empty() &&
+           stats.expanded < options.max_expansions) {
+      SearchNode node = *queue.begin();
+      queue.erase(queue.begin());
+      ++stats.expanded;
+      // its successors are composed from its signature
+      train.remember(node.ast);
+      auto at = upper_bound(partners.begin(), partners.end(), node);
+      if ((size_t)(at - partners.begin()) < options.max_partners) {
+        partners.insert(at, node);
+        if (partners.size() > options.max_partners) {
+          partners.pop_back();
+        }
+      }
+      candidates.clear();
+      successors(node.ast, candidates);
+      found = offer(candidates);
+    }
+    if (best.ast && best.accuracy < 0.5) {
+      best.ast = make_shared<Negation>(best.ast);
+      best.accuracy = 1 - best.accuracy;
+      best.size += 1;
+    }
+    return best;
+  }
+
+private:
+  // f under F and G, with an atom under &, |, U and R and with a partner
+  // under & and |, as long as they are small enough and within the traces
+  void successors(const shared_ptr<ASTNode> &f,
+                  vector<shared_ptr<ASTNode>> &out) const {
+    const size_t size = f->size(), reach = f->future_reach();
+    for (size_t lb = 0; lb <= options.max_ub; lb += options.bounds_step) {
+      for (size_t ub = lb + options.bounds_step; ub <= options.max_ub;
+           ub += options.bounds_step) {
+        if (size + 1 > options.max_size ||
+            reach + ub > options.max_trace_length) {
+          continue;
+        }
+        out.emplace_back(make_shared<Finally>(f, lb, ub));
+        out.emplace_back(make_shared<Globally>(f, lb, ub));
+      }
+    }
+    for (const shared_ptr<ASTNode> &atom : atoms) {
+      if (atom == f || size + atom->size() + 1 > options.max_size) {
+        continue;
+      }
+      out.emplace_back(make_shared<And>(f, atom));
+      out.emplace_back(make_shared<Or>(f, atom));
+      for (size_t lb = 0; lb <= options.max_ub; lb += options.bounds_step) {
+        for (size_t ub = lb + options.bounds_step; ub <= options.max_ub;
+             ub += options.bounds_step) {
+          if (reach + ub > options.max_trace_length) {
+            continue;
+          }
+          out.emplace_back(make_shared<Until>(f, atom, lb, ub));
+          out.emplace_back(make_shared<Until>(atom, f, lb, ub));
+          out.emplace_back(make_shared<Release>(f, atom, lb, ub));
+          out.emplace_back(make_shared<Release>(atom, f, lb, ub));
+        }
+      }
+    }
+    for (const SearchNode &partner : partners) {
+      if (partner.ast == f || size + partner.size + 1 > options.max_size) {
+        continue;
+      }
+      out.emplace_back(make_shared<And>(f, partner.ast));
+      out.emplace_back(make_shared<Or>(f, partner.ast));
+    }
+  }
+
+  // scores candidates and queues the ones with a new signature, returns
+  // true once best tells the traces apart, either way round
+  bool offer(vector<shared_ptr<ASTNode>> &candidates) {
+    // only the fingerprint is kept, the signature of a queued formula is
+    // computed again from its operands if it is expanded
+    vector<float> accuracy(candidates.size());
+    vector<Fingerprint> fingerprints(candidates.size());
+#pragma omp parallel for schedule(dynamic)
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      Score score = train.score(*candidates[i], -1, 2);
+      accuracy[i] = score.accuracy;
+      fingerprints[i] = fingerprint(*score.signature);
+    }
+    stats.generated += candidates.size();
+
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      if (visited.count(fingerprints[i])) {
+        ++stats.equivalent;
+        continue;
+      }
+      if (visited.size() < options.max_visited) {
+        visited.insert(fingerprints[i]);
+      }
+      SearchNode node;
+      node.ast = std::move(candidates[i]);
+      node.accuracy = accuracy[i];
+      node.size = node.ast->size();
+      node.priority = h(node);
+      node.sequence = sequence++;
+      if (!best.ast || h_dist(node) < h_dist(best)) {
+        best = node;
+      }
+      if (accuracy[i] == 1 || accuracy[i] == 0) {
+        return true;
+      }
+      queue.insert(std::move(node));
+      if (queue.size() > options.max_queue) {
+        queue.erase(prev(queue.end()));
+        ++stats.dropped;
+      }
+    }
+    return false;
+  }
+
+  SignatureScorer &train;
+  const vector<shared_ptr<ASTNode>> &atoms;
+  const Heuristic &h;
+  const BestFirstOptions &options;
+  BestFirstStats &stats;
+  set<SearchNode> queue;
+  unordered_set<Fingerprint, FingerprintHash> visited;
+  vector<SearchNode> partners; // the best expanded formulas, best first
+  SearchNode best;              // furthest from accuracy 0.5 so far
+  size_t sequence = 0;
+};
+
+SearchNode best_first_search(SignatureScorer &train,
+                             const vector<shared_ptr<ASTNode>> &atoms,
+                             const Heuristic &h,
+                             const BestFirstOptions &options,
+                             BestFirstStats &stats) {
+  return BestFirst(train, atoms, h, options, stats).run();
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ast.hh"
+#include "signature.hh"
+
+/* A formula reached by best_first_search(), scored on the train traces
+ */
+struct SearchNode {
+  std::shared_ptr<libmltl::ASTNode> ast;
+  float accuracy = 0;
+  size_t size = 0;
+  float priority = 0; // the lower, the sooner it is expanded
+  size_t sequence = 0; // order it was queued in
+
+  // determines position in the queue, break ties with the smaller formula
+  // and then the one queued first
+  bool operator<(const SearchNode &rhs) const;
+};
+
+/* Priority of a node from its accuracy and size, see make_heuristic()
+ */
+typedef std::function<float(const SearchNode &)> Heuristic;
+
+/* Heuristics by name, empty if there is no such heuristic:
+ *   dist   how far the formula is from telling the traces apart, either way
+ *          round: 0.5 - |accuracy - 0.5|, greedy best-first
+ *   size   its number of nodes, expands every formula of a size before the
+ *          next one like an exhaustive enumeration would
+ *   astar  size + weight * 2 * dist, A* with the size as the cost so far and
+ *          the distance scaled to the nodes it is expected to still need
+ */
+Heuristic make_heuristic(const std::string &name, float weight);
+
+/* Limits of best_first_search(). Every expanded formula keeps its train
+ * signature for the formulas built on top of it, so max_expansions bounds
+ * the memory of the scorer, the other two that of the search itself.
+ */
+struct BestFirstOptions {
+  size_t max_expansions = 2000;   // formulas taken out of the queue
+  size_t max_queue = 1000000;     // past it the lowest priority ones go
+  size_t max_visited = 4000000;   // signatures seen, past it a new one is
+                                  // no longer recorded, only looked up
+  size_t max_size = 16;           // nodes of a formula
+  size_t max_partners = 64;       // expanded formulas combined with & and |
+  size_t max_ub = 0;              // bounds of the temporal operators
+  size_t bounds_step = 1;
+  size_t max_trace_length = 0;    // limit on the future reach of a formula
+};
+
+struct BestFirstStats {
+  size_t expanded = 0;   // formulas taken out of the queue
+  size_t generated = 0;  // successors scored on the train traces
+  size_t equivalent = 0; // of those, with a signature already seen
+  size_t dropped = 0;    // of those, pushed out of a full queue
+};
+
+/* Searches for a formula that tells the train traces apart, accuracy 1, or
+ * whose negation does, accuracy 0. Starts from atoms and repeatedly expands
+ * the formula of lowest priority under h: its successors put it under F
+ * and G, combine it with an atom under &, |, U and R in either order, and
+ * with the best expanded formulas so far under & and |. Successors are
+ * scored from the signatures of their operands and one is kept per train
+ * signature, so a formula equivalent to one already seen is not queued.
+ *
+ * Returns the first formula found with accuracy 1, or if the queue runs out
+ * or a limit is reached first, the most accurate one seen. A formula below
+ * accuracy 0.5 is returned negated.
+ */
+SearchNode best_first_search(
+    SignatureScorer &train,
+    const std::vector<std::shared_ptr<libmltl::ASTNode>> &atoms,
+    const Heuristic &h, const BestFirstOptions &options,
+    BestFirstStats &stats);
@@ -1,14 +1,21 @@
+#include <algorithm>
 #include <boost/container/flat_set.hpp>
 #include <cmath>
 #include <cstdint>
 #include <functional>
 #include <iostream>
+#include <omp.h>
 #include <set>
 #include <sys/time.h>
+#include <unordered_map>
 
 // #include "evaluate_mltl.h"
+#include "best_first.hh"
 #include "parser.hh"
 #include "quine_mccluskey.hh"
+#include "signature.hh"
+#include "simplify.hh"
+#include "trace_set.h"
 
 using namespace std;
 using namespace libmltl;
@@ -33,8 +40,11 @@ public:
   shared_ptr<ASTNode> ast;
   float accuracy;
   int depth;
-  NodeWrapper(shared_ptr<ASTNode> ast, float accuracy, int depth)
-      : ast(std::move(ast)), accuracy(accuracy), depth(depth) {}
+  Fingerprint fingerprint; // of its train signature, see signature.hh
+  NodeWrapper(shared_ptr<ASTNode> ast, float accuracy, int depth,
+              Fingerprint fingerprint)
+      : ast(std::move(ast)), accuracy(accuracy), depth(depth),
+        fingerprint(fingerprint) {}
 
   // determines position in set, break ties with ast lexicographical compare.
   bool operator<(const NodeWrapper &rhs) const {
@@ -169,58 +179,278 @@ void generate_formulas(vector<shared_ptr<ASTNode>> &formulas, int vars,
   return;
 }
 
+// size and estimated cost of every formula calc_accuracy evaluated, summed
+// before and after simplification
+struct SimplifyStats {
+  size_t nodes_before = 0;
+  size_t nodes_after = 0;
+  double cost_before = 0;
+  double cost_after = 0;
+};
+SimplifyStats simplify_stats;
+
 float calc_accuracy(const ASTNode &f, vector<vector<string>> &pos,
                     vector<vector<string>> &neg) {
+  // simplified once, evaluated on every trace
+  shared_ptr<ASTNode> simplified = simplify(f);
+  size_t nodes_before = f.size(), nodes_after = simplified->size();
+  double cost_before = evaluation_cost(f),
+         cost_after = evaluation_cost(*simplified);
+#pragma omp atomic
+  simplify_stats.nodes_before += nodes_before;
+#pragma omp atomic
+  simplify_stats.nodes_after += nodes_after;
+#pragma omp atomic
+  simplify_stats.cost_before += cost_before;
+#pragma omp atomic
+  simplify_stats.cost_after += cost_after;
+
   int traces_satisified = 0;
   for (size_t j = 0; j < pos.size(); ++j) {
-    traces_satisified += f.evaluate(pos[j]);
+    traces_satisified += simplified->evaluate(pos[j]);
   }
   for (size_t j = 0; j < neg.size(); ++j) {
-    traces_satisified += !f.evaluate(neg[j]);
+    traces_satisified += !simplified->evaluate(neg[j]);
   }
   return traces_satisified / (float)(pos.size() + neg.size());
 };
 
-bool keep_best(
-    boost::container::flat_set<NodeWrapper> &formulas_best,
-    boost::container::flat_set<NodeWrapper, std::greater<NodeWrapper>>
-        &formulas_worst,
-    shared_ptr<ASTNode> new_f, float acc, int depth, size_t num_to_keep) {
-  bool inserted = false;
-  if (formulas_worst.size() < num_to_keep) {
-    formulas_worst.emplace(new_f, acc, depth);
-    formulas_best.emplace(std::move(new_f), acc, depth);
-    return true;
-  }
-  if (formulas_worst.begin()->accuracy > acc) {
-    formulas_worst.erase(formulas_worst.begin());
-    formulas_worst.emplace(new_f, acc, depth);
-    inserted = true;
-  }
-  if (formulas_best.begin()->accuracy < acc) {
-    formulas_best.erase(formulas_best.begin());
-    formulas_best.emplace(std::move(new_f), acc, depth);
-    inserted = true;
-  }
-  return inserted;
-}
+// candidates offered to the top-k collectors, and why the ones that were
+// not kept were dropped
+struct PruneStats {
+  size_t offered = 0;
+  size_t below_threshold = 0; // not better than the k-th best or worst
+  size_t equivalent = 0;      // same signature as a formula already kept
+  size_t abandoned = 0;       // of below_threshold, before the last trace
+  size_t traces_scored = 0;   // of offered times the number of traces
+};
+PruneStats prune_stats;
+
+/* A set of at most num_to_keep formulas ordered weakest first, one per
+ * train signature, with the formula kept for each fingerprint.
+ */
+template <class Compare = std::less<NodeWrapper>> class KeptFormulas {
+public:
+  typedef boost::container::flat_set<NodeWrapper, Compare> Set;
+
+  typename Set::const_iterator begin() const { return set.begin(); }
+  typename Set::const_iterator end() const { return set.end(); }
+  size_t size() const { return set.size(); }
+
+  /* Inserts new_f if it is stronger than the weakest formula. A formula
+   * with the same fingerprint as new_f is replaced if new_f is smaller, and
+   * keeps its place otherwise. Returns true if there was such a formula.
+   */
+  bool keep(const NodeWrapper &new_f, size_t num_to_keep) {
+    auto same = by_fingerprint.find(new_f.fingerprint);
+    if (same != by_fingerprint.end()) {
+      if (new_f.ast->size() < same->second.ast->size()) {
+        set.erase(same->second);
+        set.insert(new_f);
+        same->second = new_f;
+      }
+      return true;
+    }
+    if (set.size() == num_to_keep) {
+      if (!set.value_comp()(*set.begin(), new_f)) {
+        return false;
+      }
+      by_fingerprint.erase(set.begin()->fingerprint);
+      set.erase(set.begin());
+    }
+    set.insert(new_f);
+    by_fingerprint.emplace(new_f.fingerprint, new_f);
+    return false;
+  }
+
+private:
+  Set set;
+  std::unordered_map<Fingerprint, NodeWrapper, FingerprintHash>
+      by_fingerprint;
+};
+
+/* The best and the worst num_to_keep candidates seen by one thread, in two
+ * bounded heaps whose front is the weakest formula kept. A candidate that
+ * does not reach the fronts is rejected after scoring with two comparisons.
+ * One that agrees with a kept formula on every train position has its
+ * accuracy, so it is at least tied with a front; it is looked up by
+ * fingerprint before the fronts are compared and only replaces the kept
+ * formula if it is smaller. Nothing is shared between threads until
+ * merge_into() after the parallel loop.
+ */
+class alignas(64) TopK {
+public:
+  TopK(const SignatureScorer &train, size_t num_to_keep)
+      : train(&train), num_to_keep(num_to_keep) {}
+
+  void offer(shared_ptr<ASTNode> f, int depth) {
+    ++stats.offered;
+    // a candidate must beat the front of a full heap to get in
+    float best_bound = best.size() < num_to_keep ? -1 : best.front().accuracy;
+    float worst_bound =
+        worst.size() < num_to_keep ? 2 : worst.front().accuracy;
+    Score score = train->score(*f, best_bound, worst_bound);
+    stats.traces_scored += score.traces;
+    if (score.abandoned) {
+      ++stats.below_threshold;
+      ++stats.abandoned;
+      check_abandoned(*f, best_bound, worst_bound);
+      return;
+    }
+    float acc = score.accuracy;
+    bool for_worst = acc <= worst_bound;
+    bool for_best = acc >= best_bound;
+    if (!for_worst && !for_best) {
+      ++stats.below_threshold;
+      return;
+    }
+    NodeWrapper new_f(std::move(f), acc, depth, fingerprint(*score.signature));
+    bool equivalent = false;
+    if (for_worst) {
+      equivalent |= push(worst, worst_sizes, new_f, acc < worst_bound,
+                         std::less<NodeWrapper>());
+    }
+    if (for_best) {
+      equivalent |= push(best, best_sizes, new_f, acc > best_bound,
+                         std::greater<NodeWrapper>());
+    }
+    stats.equivalent += equivalent;
+    // a tie with a front that is new to both heaps is not kept
+    if (!equivalent && acc <= best_bound && acc >= worst_bound) {
+      ++stats.below_threshold;
+    }
+  }
+
+  void merge_into(KeptFormulas<> &formulas_best,
+                  KeptFormulas<std::greater<NodeWrapper>> &formulas_worst) {
+    for (const NodeWrapper &f : best) {
+      stats.equivalent += formulas_best.keep(f, num_to_keep);
+    }
+    for (const NodeWrapper &f : worst) {
+      formulas_worst.keep(f, num_to_keep);
+    }
+    best.clear();
+    worst.clear();
+    best_sizes.clear();
+    worst_sizes.clear();
+    prune_stats.offered += stats.offered;
+    prune_stats.below_threshold += stats.below_threshold;
+    prune_stats.equivalent += stats.equivalent;
+    prune_stats.abandoned += stats.abandoned;
+    prune_stats.traces_scored += stats.traces_scored;
+    stats = PruneStats();
+  }
+
+private:
+  // without pruning, an abandoned candidate must not have changed the heaps:
+  // it is strictly between the fronts, so it neither beats them nor shares
+  // a signature with a kept formula
+  void check_abandoned(const ASTNode &f, float best_bound,
+                       float worst_bound) const {
+#ifdef DEBUG
+    float acc = train->score(f, -1, 2).accuracy;
+    if (acc >= best_bound || acc <= worst_bound) {
+      cerr << "abandoned " << f.as_pretty_string() << " with accuracy " << acc
+           << " would have been kept\n";
+      abort();
+    }
+#endif
+  }
+
+  typedef std::unordered_map<Fingerprint, size_t, FingerprintHash> Sizes;
+
+  // returns true if a formula with the same fingerprint was in heap, which
+  // new_f then replaces if it is smaller, and otherwise pushes new_f if it
+  // beats the front of a full heap. sizes holds the size of the formula kept
+  // for every fingerprint in heap.
+  template <class Compare>
+  bool push(vector<NodeWrapper> &heap, Sizes &sizes, const NodeWrapper &new_f,
+            bool beats_front, Compare comp) {
+    auto same = sizes.find(new_f.fingerprint);
+    if (same != sizes.end()) {
+      if (new_f.ast->size() < same->second) {
+        // rare, and the search costs no more than restoring the heap
+        *std::find_if(heap.begin(), heap.end(), [&](const NodeWrapper &f) {
+          return f.fingerprint == new_f.fingerprint;
+        }) = new_f;
+        make_heap(heap.begin(), heap.end(), comp);
+        same->second = new_f.ast->size();
+      }
+      return true;
+    }
+    if (!beats_front) {
+      return false;
+    }
+    if (heap.size() == num_to_keep) {
+      pop_heap(heap.begin(), heap.end(), comp);
+      sizes.erase(heap.back().fingerprint);
+      heap.pop_back();
+    }
+    heap.push_back(new_f);
+    push_heap(heap.begin(), heap.end(), comp);
+    sizes.emplace(new_f.fingerprint, new_f.ast->size());
+    return false;
+  }
+
+  const SignatureScorer *train;
+  size_t num_to_keep;
+  vector<NodeWrapper> best;  // min-heap, front is the least accurate
+  vector<NodeWrapper> worst; // max-heap, front is the most accurate
+  Sizes best_sizes, worst_sizes;
+  PruneStats stats;
+};
 
 int main(int argc, char *argv[]) {
   // default options
-  // TODO
+  bool best_first = false;
+  string heuristic_name = "astar";
+  float weight = 10;
+  BestFirstOptions best_first_options;
 
   for (int i = 1; i < argc; ++i) {
     string arg = argv[i];
 
     if (arg == "-h" || arg == "--help") {
-      // TODO
-      // eval_func_p1 = stoi(argv[i + 1]);
-      // i++;
+      cout << "usage: " << argv[0] << " [options]\n"
+           << "  --best-first         search best-first instead of by depth\n"
+           << "  --heuristic NAME     dist, size or astar (default), see "
+              "best_first.hh\n"
+           << "  --weight W           weight of dist in astar (default 10)\n"
+           << "  --max-expansions N   formulas expanded before giving up\n"
+           << "  --max-queue N        formulas waiting to be expanded\n"
+           << "  --max-visited N      signatures remembered as seen\n"
+           << "  --max-size N         nodes of a formula\n";
+      return 0;
+    } else if (arg == "--best-first") {
+      best_first = true;
+    } else if (i + 1 < argc && arg == "--heuristic") {
+      heuristic_name = argv[i + 1];
+      i++;
+    } else if (i + 1 < argc && arg == "--weight") {
+      weight = stof(argv[i + 1]);
+      i++;
+    } else if (i + 1 < argc && arg == "--max-expansions") {
+      best_first_options.max_expansions = stoul(argv[i + 1]);
+      i++;
+    } else if (i + 1 < argc && arg == "--max-queue") {
+      best_first_options.max_queue = stoul(argv[i + 1]);
+      i++;
+    } else if (i + 1 < argc && arg == "--max-visited") {
+      best_first_options.max_visited = stoul(argv[i + 1]);
+      i++;
+    } else if (i + 1 < argc && arg == "--max-size") {
+      best_first_options.max_size = stoul(argv[i + 1]);
+      i++;
     } else {
       cerr << "error: unknown option " << arg << endl;
       return 1;
     }
   }
+  Heuristic heuristic = make_heuristic(heuristic_name, weight);
+  if (!heuristic) {
+    cerr << "error: unknown heuristic " << heuristic_name << endl;
+    return 1;
+  }
 
   // string base_path = "../dataset/nasa-atc_formula1";
   // string base_path = "../dataset/nasa-atc_formula2";
@@ -233,17 +463,27 @@ int main(int argc, char *argv[]) {
   // string base_path = "../dataset/basic_global";
   // string base_path = "../dataset/basic_release";
   // string base_path = "../dataset/basic_until";
-  vector<vector<string>> traces_pos_train =
-      read_trace_files(base_path + "/pos_train");
+  // prefer the packed trace set written by
+  //   MLTL_interpreter/bin/trace_pack <base_path> <base_path>/traces.mlts
+  // over reading every trace file of the four directories
+  string trace_set_path = base_path + "/traces.mlts";
+  vector<vector<string>> traces_pos_train, traces_neg_train, traces_pos_test,
+      traces_neg_test;
+  if (is_trace_set(trace_set_path)) {
+    TraceSet trace_set(trace_set_path);
+    traces_pos_train = read_trace_set_group(trace_set, "pos_train");
+    traces_neg_train = read_trace_set_group(trace_set, "neg_train");
+    traces_pos_test = read_trace_set_group(trace_set, "pos_test");
+    traces_neg_test = read_trace_set_group(trace_set, "neg_test");
+  } else {
+    traces_pos_train = read_trace_files(base_path + "/pos_train");
+    traces_neg_train = read_trace_files(base_path + "/neg_train");
+    traces_pos_test = read_trace_files(base_path + "/pos_test");
+    traces_neg_test = read_trace_files(base_path + "/neg_test");
+  }
   size_t max_pos_train_trace_len = max_trace_length(traces_pos_train);
-  vector<vector<string>> traces_neg_train =
-      read_trace_files(base_path + "/neg_train");
   size_t max_neg_train_trace_len = max_trace_length(traces_neg_train);
-  vector<vector<string>> traces_pos_test =
-      read_trace_files(base_path + "/pos_test");
   size_t max_pos_test_trace_len = max_trace_length(traces_pos_test);
-  vector<vector<string>> traces_neg_test =
-      read_trace_files(base_path + "/neg_test");
   size_t max_neg_test_trace_len = max_trace_length(traces_neg_test);
 
   struct timeval start, end;
@@ -324,6 +564,10 @@ int main(int argc, char *argv[]) {
 
   size_t max_ub = max_pos_train_trace_len - 1;
 
+  // candidates are scored from the signatures of their operands, see
+  // signature.hh, calc_accuracy is left for the test traces
+  SignatureScorer train(traces_pos_train, traces_neg_train);
+
   boost::container::flat_set<shared_ptr<ASTNode>, ASTNodeSharedPtrCompare>
       interesting_bool_funcs;
 
@@ -334,16 +578,16 @@ int main(int argc, char *argv[]) {
   }
 #pragma omp parallel for schedule(dynamic)
   for (size_t i = 0; i < num_boolean_functions; ++i) {
-    if (calc_accuracy(*make_shared<Finally>(bool_funcs[i], 0, max_ub),
-                      traces_pos_train, traces_neg_train) > 0.5) {
+    if (train.accuracy(*make_shared<Finally>(bool_funcs[i], 0, max_ub)) >
+        0.5) {
 #pragma omp critical
       interesting_bool_funcs.emplace(bool_funcs[i]);
     }
   }
 #pragma omp parallel for schedule(dynamic)
   for (size_t i = 0; i < num_boolean_functions; ++i) {
-    if (calc_accuracy(*make_shared<Globally>(bool_funcs[i], 0, max_ub),
-                      traces_pos_train, traces_neg_train) > 0.5) {
+    if (train.accuracy(*make_shared<Globally>(bool_funcs[i], 0, max_ub)) >
+        0.5) {
 #pragma omp critical
       interesting_bool_funcs.emplace(bool_funcs[i]);
     }
@@ -353,32 +597,70 @@ int main(int argc, char *argv[]) {
     cout << formula->as_pretty_string() << "\n";
   }
   cout << "interesting bool funcs: " << interesting_bool_funcs.size() << "\n";
+  for (auto &formula : interesting_bool_funcs) {
+    train.remember(formula);
+  }
+  train.order_traces(vector<shared_ptr<ASTNode>>(
+      interesting_bool_funcs.begin(), interesting_bool_funcs.end()));
+
+  if (best_first) {
+    // expands formulas from the smaller interesting boolean functions up,
+    // instead of sweeping every formula of a depth
+    vector<shared_ptr<ASTNode>> atoms;
+    for (auto &formula : interesting_bool_funcs) {
+      if (formula->size() <= max_bool_func_size) {
+        atoms.push_back(formula);
+      }
+    }
+    best_first_options.max_ub = max_ub;
+    best_first_options.bounds_step = bounds_step;
+    best_first_options.max_trace_length = max_pos_train_trace_len;
+    BestFirstStats stats;
+    cout << "BEST-FIRST SEARCH (" << heuristic_name << ")\n";
+    SearchNode found =
+        best_first_search(train, atoms, heuristic, best_first_options, stats);
+
+    gettimeofday(&end, NULL); // stop timer
+    time_taken = end.tv_sec + end.tv_usec / 1e6 - start.tv_sec -
+                 start.tv_usec / 1e6; // in seconds
+    if (found.accuracy < 1) {
+      cout << "no formula tells the train traces apart within the limits, "
+              "the best one seen:\n";
+    }
+    if (found.ast) {
+      cout << found.ast->as_pretty_string() << "\n";
+      cout << "  train accuracy: " << found.accuracy << "\n";
+      cout << "  test accuracy : "
+           << calc_accuracy(*found.ast, traces_pos_test, traces_neg_test)
+           << "\n";
+    }
+    cout << "nodes expanded: " << stats.expanded << "\n";
+    cout << "candidates scored: " << stats.generated << "\n";
+    cout << "  pruned as equivalent on the train traces: " << stats.equivalent
+         << "\n";
+    cout << "  dropped from the full queue: " << stats.dropped << "\n";
+    cout << "remembered signatures: " << train.num_remembered() << "\n";
+    cout << "total time taken: " << time_taken << "s\n";
+    return 0;
+  }
 
-  boost::container::flat_set<NodeWrapper> formulas_best;
-  boost::container::flat_set<NodeWrapper, std::greater<NodeWrapper>>
-      formulas_worst;
+  KeptFormulas<> formulas_best;
+  KeptFormulas<std::greater<NodeWrapper>> formulas_worst;
+
+  // one collector per thread, merged once the depth is done
+  vector<TopK> tops(omp_get_max_threads(), TopK(train, max_formulas));
 
   cout << "GENERATING DEPTH 1 FUNCTIONS\n";
 #pragma omp parallel for schedule(dynamic)
   for (auto &operand1 : interesting_bool_funcs) {
+    TopK &top = tops[omp_get_thread_num()];
     for (size_t lb = 0; lb <= max_ub; lb += bounds_step) {
       for (size_t ub = lb + bounds_step; ub <= max_ub; ub += bounds_step) {
         shared_ptr<ASTNode> candidate = make_shared<Globally>(operand1, lb, ub);
-        float acc =
-            calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-        {
-          keep_best(formulas_best, formulas_worst, std::move(candidate), acc, 1,
-                    max_formulas);
-        }
+        top.offer(std::move(candidate), 1);
 
         candidate = make_shared<Finally>(operand1, lb, ub);
-        acc = calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-        {
-          keep_best(formulas_best, formulas_worst, std::move(candidate), acc, 1,
-                    max_formulas);
-        }
+        top.offer(std::move(candidate), 1);
       }
     }
   }
@@ -398,6 +680,7 @@ int main(int argc, char *argv[]) {
 
 #pragma omp parallel for schedule(dynamic)
   for (auto &operand1 : interesting_bool_funcs) {
+    TopK &top = tops[omp_get_thread_num()];
     for (auto &operand2 : interesting_bool_funcs) {
       if (operand1 == operand2) {
         continue;
@@ -406,35 +689,34 @@ int main(int argc, char *argv[]) {
         for (size_t ub = lb + bounds_step; ub <= max_ub; ub += bounds_step) {
           shared_ptr<ASTNode> candidate =
               make_shared<Until>(operand1, operand2, lb, ub);
-          float acc =
-              calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-          {
-            keep_best(formulas_best, formulas_worst, std::move(candidate), acc,
-                      1, max_formulas);
-          }
+          top.offer(std::move(candidate), 1);
 
           candidate = make_shared<Release>(operand1, operand2, lb, ub);
-          acc = calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-          {
-            keep_best(formulas_best, formulas_worst, std::move(candidate), acc,
-                      1, max_formulas);
-          }
+          top.offer(std::move(candidate), 1);
         }
       }
     }
   }
 
+  for (TopK &top : tops) {
+    top.merge_into(formulas_best, formulas_worst);
+  }
+
   for (int depth = 2; depth <= max_depth; ++depth) {
     cout << "GENERATING DEPTH " << depth << " FUNCTIONS\n";
-    boost::container::flat_set<NodeWrapper> candidates_best;
-    boost::container::flat_set<NodeWrapper, std::greater<NodeWrapper>>
-        candidates_worst;
+    // the operands of this depth are composed from their signatures
+    vector<shared_ptr<ASTNode>> operands;
+    for (auto &formula : formulas_best) {
+      train.remember(formula.ast);
+      operands.push_back(formula.ast);
+    }
+    train.order_traces(operands);
+    KeptFormulas<> candidates_best;
+    KeptFormulas<std::greater<NodeWrapper>> candidates_worst;
 #pragma omp parallel for schedule(dynamic)
     for (auto &operand1 : formulas_best) {
+      TopK &top = tops[omp_get_thread_num()];
       shared_ptr<ASTNode> candidate;
-      float acc;
       for (size_t lb = 0; lb <= max_ub; lb += bounds_step) {
         for (size_t ub = lb + bounds_step; ub <= max_ub; ub += bounds_step) {
           if (operand1.ast->future_reach() + ub > max_pos_train_trace_len) {
@@ -442,20 +724,10 @@ int main(int argc, char *argv[]) {
           }
           if (operand1.depth == depth - 1) {
             candidate = make_shared<Globally>(operand1.ast, lb, ub);
-            acc = calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-            {
-              keep_best(candidates_best, candidates_worst, std::move(candidate),
-                        acc, depth, max_formulas);
-            }
+            top.offer(std::move(candidate), depth);
 
             candidate = make_shared<Finally>(operand1.ast, lb, ub);
-            acc = calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-            {
-              keep_best(candidates_best, candidates_worst, std::move(candidate),
-                        acc, depth, max_formulas);
-            }
+            top.offer(std::move(candidate), depth);
           }
 
           for (auto &operand2 : formulas_best) {
@@ -470,99 +742,41 @@ int main(int argc, char *argv[]) {
             }
 
             candidate = make_shared<Until>(operand1.ast, operand2.ast, lb, ub);
-            acc = calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-            {
-              keep_best(candidates_best, candidates_worst, std::move(candidate),
-                        acc, depth, max_formulas);
-            }
+            top.offer(std::move(candidate), depth);
 
             candidate =
                 make_shared<Release>(operand1.ast, operand2.ast, lb, ub);
-            acc = calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-            {
-              keep_best(candidates_best, candidates_worst, std::move(candidate),
-                        acc, depth, max_formulas);
-            }
+            top.offer(std::move(candidate), depth);
           }
 
           if (operand1.depth == depth - 1) {
             // (2) GENERATE FORMULAS WITH AT LEAST ONE DEPTH -1 formula.
             for (auto &operand2 : interesting_bool_funcs) {
               candidate = make_shared<Until>(operand1.ast, operand2, lb, ub);
-              acc =
-                  calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-              {
-                keep_best(candidates_best, candidates_worst,
-                          std::move(candidate), acc, depth, max_formulas);
-              }
+              top.offer(std::move(candidate), depth);
 
               candidate = make_shared<Release>(operand1.ast, operand2, lb, ub);
-              acc =
-                  calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-              {
-                keep_best(candidates_best, candidates_worst,
-                          std::move(candidate), acc, depth, max_formulas);
-              }
+              top.offer(std::move(candidate), depth);
 
               candidate = make_shared<Until>(operand2, operand1.ast, lb, ub);
-              acc =
-                  calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-              {
-                keep_best(candidates_best, candidates_worst,
-                          std::move(candidate), acc, depth, max_formulas);
-              }
+              top.offer(std::move(candidate), depth);
 
               candidate = make_shared<Release>(operand2, operand1.ast, lb, ub);
-              acc =
-                  calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-              {
-                keep_best(candidates_best, candidates_worst,
-                          std::move(candidate), acc, depth, max_formulas);
-              }
+              top.offer(std::move(candidate), depth);
 
               // use some binary propositional operations now.
               candidate = make_shared<Globally>(
                   make_shared<And>(operand1.ast, operand2), lb, ub);
-              acc =
-                  calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-              {
-                keep_best(candidates_best, candidates_worst,
-                          std::move(candidate), acc, depth, max_formulas);
-              }
+              top.offer(std::move(candidate), depth);
               candidate = make_shared<Finally>(
                   make_shared<And>(operand1.ast, operand2), lb, ub);
-              acc =
-                  calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-              {
-                keep_best(candidates_best, candidates_worst,
-                          std::move(candidate), acc, depth, max_formulas);
-              }
+              top.offer(std::move(candidate), depth);
               candidate = make_shared<Globally>(
                   make_shared<Or>(operand1.ast, operand2), lb, ub);
-              acc =
-                  calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-              {
-                keep_best(candidates_best, candidates_worst,
-                          std::move(candidate), acc, depth, max_formulas);
-              }
+              top.offer(std::move(candidate), depth);
               candidate = make_shared<Finally>(
                   make_shared<Or>(operand1.ast, operand2), lb, ub);
-              acc =
-                  calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-              {
-                keep_best(candidates_best, candidates_worst,
-                          std::move(candidate), acc, depth, max_formulas);
-              }
+              top.offer(std::move(candidate), depth);
 
               // NEGATED
               // use some binary propositional operations now.
@@ -572,46 +786,22 @@ int main(int argc, char *argv[]) {
                     make_shared<And>(operand1.ast,
                                      make_shared<Negation>(operand2)),
                     lb, ub);
-                acc = calc_accuracy(*candidate, traces_pos_train,
-                                    traces_neg_train);
-#pragma omp critical
-                {
-                  keep_best(candidates_best, candidates_worst,
-                            std::move(candidate), acc, depth, max_formulas);
-                }
+                top.offer(std::move(candidate), depth);
                 candidate = make_shared<Finally>(
                     make_shared<And>(operand1.ast,
                                      make_shared<Negation>(operand2)),
                     lb, ub);
-                acc = calc_accuracy(*candidate, traces_pos_train,
-                                    traces_neg_train);
-#pragma omp critical
-                {
-                  keep_best(candidates_best, candidates_worst,
-                            std::move(candidate), acc, depth, max_formulas);
-                }
+                top.offer(std::move(candidate), depth);
                 candidate = make_shared<Globally>(
                     make_shared<Or>(operand1.ast,
                                     make_shared<Negation>(operand2)),
                     lb, ub);
-                acc = calc_accuracy(*candidate, traces_pos_train,
-                                    traces_neg_train);
-#pragma omp critical
-                {
-                  keep_best(candidates_best, candidates_worst,
-                            std::move(candidate), acc, depth, max_formulas);
-                }
+                top.offer(std::move(candidate), depth);
                 candidate = make_shared<Finally>(
                     make_shared<Or>(operand1.ast,
                                     make_shared<Negation>(operand2)),
                     lb, ub);
-                acc = calc_accuracy(*candidate, traces_pos_train,
-                                    traces_neg_train);
-#pragma omp critical
-                {
-                  keep_best(candidates_best, candidates_worst,
-                            std::move(candidate), acc, depth, max_formulas);
-                }
+                top.offer(std::move(candidate), depth);
               }
             }
           }
@@ -625,8 +815,8 @@ int main(int argc, char *argv[]) {
     /*
 #pragma omp parallel for schedule(dynamic)
     for (auto &operand1 : formulas_worst) {
+      TopK &top = tops[omp_get_thread_num()];
       shared_ptr<ASTNode> candidate;
-      float acc;
       for (size_t lb = 0; lb <= max_ub; lb += bounds_step) {
         for (size_t ub = lb + bounds_step; ub <= max_ub; ub += bounds_step) {
           if (operand1.ast->future_reach() + ub > max_pos_train_trace_len) {
@@ -634,20 +824,10 @@ int main(int argc, char *argv[]) {
           }
           if (operand1.depth == depth - 1) {
             candidate = make_shared<Globally>(operand1.ast, lb, ub);
-            acc = calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-            {
-              keep_best(candidates_best, candidates_worst, std::move(candidate),
-                        acc, depth, max_formulas);
-            }
+            top.offer(std::move(candidate), depth);
 
             candidate = make_shared<Finally>(operand1.ast, lb, ub);
-            acc = calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-            {
-              keep_best(candidates_best, candidates_worst, std::move(candidate),
-                        acc, depth, max_formulas);
-            }
+            top.offer(std::move(candidate), depth);
           }
 
           for (auto &operand2 : formulas_best) {
@@ -662,116 +842,48 @@ int main(int argc, char *argv[]) {
             }
 
             candidate = make_shared<Until>(operand1.ast, operand2.ast, lb, ub);
-            acc = calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-            {
-              keep_best(candidates_best, candidates_worst, std::move(candidate),
-                        acc, depth, max_formulas);
-            }
+            top.offer(std::move(candidate), depth);
 
             candidate =
                 make_shared<Release>(operand1.ast, operand2.ast, lb, ub);
-            acc = calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-            {
-              keep_best(candidates_best, candidates_worst, std::move(candidate),
-                        acc, depth, max_formulas);
-            }
+            top.offer(std::move(candidate), depth);
 
             candidate = make_shared<Until>(operand2.ast, operand1.ast, lb, ub);
-            acc = calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-            {
-              keep_best(candidates_best, candidates_worst, std::move(candidate),
-                        acc, depth, max_formulas);
-            }
+            top.offer(std::move(candidate), depth);
 
             candidate =
                 make_shared<Release>(operand2.ast, operand1.ast, lb, ub);
-            acc = calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-            {
-              keep_best(candidates_best, candidates_worst, std::move(candidate),
-                        acc, depth, max_formulas);
-            }
+            top.offer(std::move(candidate), depth);
           }
 
           if (operand1.depth == depth - 1) {
             // (2) GENERATE FORMULAS WITH AT LEAST ONE DEPTH -1 formula.
             for (auto &operand2 : interesting_bool_funcs) {
               candidate = make_shared<Until>(operand1.ast, operand2, lb, ub);
-              acc =
-                  calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-              {
-                keep_best(candidates_best, candidates_worst,
-                          std::move(candidate), acc, depth, max_formulas);
-              }
+              top.offer(std::move(candidate), depth);
 
               candidate = make_shared<Release>(operand1.ast, operand2, lb, ub);
-              acc =
-                  calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-              {
-                keep_best(candidates_best, candidates_worst,
-                          std::move(candidate), acc, depth, max_formulas);
-              }
+              top.offer(std::move(candidate), depth);
 
               candidate = make_shared<Until>(operand2, operand1.ast, lb, ub);
-              acc =
-                  calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-              {
-                keep_best(candidates_best, candidates_worst,
-                          std::move(candidate), acc, depth, max_formulas);
-              }
+              top.offer(std::move(candidate), depth);
 
               candidate = make_shared<Release>(operand2, operand1.ast, lb, ub);
-              acc =
-                  calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-              {
-                keep_best(candidates_best, candidates_worst,
-                          std::move(candidate), acc, depth, max_formulas);
-              }
+              top.offer(std::move(candidate), depth);
 
               // use some binary propositional operations now.
               candidate = make_shared<Globally>(
                   make_shared<And>(operand1.ast, operand2), lb, ub);
-              acc =
-                  calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-              {
-                keep_best(candidates_best, candidates_worst,
-                          std::move(candidate), acc, depth, max_formulas);
-              }
+              top.offer(std::move(candidate), depth);
               candidate = make_shared<Finally>(
                   make_shared<And>(operand1.ast, operand2), lb, ub);
-              acc =
-                  calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-              {
-                keep_best(candidates_best, candidates_worst,
-                          std::move(candidate), acc, depth, max_formulas);
-              }
+              top.offer(std::move(candidate), depth);
               candidate = make_shared<Globally>(
                   make_shared<Or>(operand1.ast, operand2), lb, ub);
-              acc =
-                  calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-              {
-                keep_best(candidates_best, candidates_worst,
-                          std::move(candidate), acc, depth, max_formulas);
-              }
+              top.offer(std::move(candidate), depth);
               candidate = make_shared<Finally>(
                   make_shared<Or>(operand1.ast, operand2), lb, ub);
-              acc =
-                  calc_accuracy(*candidate, traces_pos_train, traces_neg_train);
-#pragma omp critical
-              {
-                keep_best(candidates_best, candidates_worst,
-                          std::move(candidate), acc, depth, max_formulas);
-              }
+              top.offer(std::move(candidate), depth);
 
               // NEGATED
               // use some binary propositional operations now.
@@ -781,46 +893,22 @@ int main(int argc, char *argv[]) {
                     make_shared<And>(operand1.ast,
                                      make_shared<Negation>(operand2)),
                     lb, ub);
-                acc = calc_accuracy(*candidate, traces_pos_train,
-                                    traces_neg_train);
-#pragma omp critical
-                {
-                  keep_best(candidates_best, candidates_worst,
-                            std::move(candidate), acc, depth, max_formulas);
-                }
+                top.offer(std::move(candidate), depth);
                 candidate = make_shared<Finally>(
                     make_shared<And>(operand1.ast,
                                      make_shared<Negation>(operand2)),
                     lb, ub);
-                acc = calc_accuracy(*candidate, traces_pos_train,
-                                    traces_neg_train);
-#pragma omp critical
-                {
-                  keep_best(candidates_best, candidates_worst,
-                            std::move(candidate), acc, depth, max_formulas);
-                }
+                top.offer(std::move(candidate), depth);
                 candidate = make_shared<Globally>(
                     make_shared<Or>(operand1.ast,
                                     make_shared<Negation>(operand2)),
                     lb, ub);
-                acc = calc_accuracy(*candidate, traces_pos_train,
-                                    traces_neg_train);
-#pragma omp critical
-                {
-                  keep_best(candidates_best, candidates_worst,
-                            std::move(candidate), acc, depth, max_formulas);
-                }
+                top.offer(std::move(candidate), depth);
                 candidate = make_shared<Finally>(
                     make_shared<Or>(operand1.ast,
                                     make_shared<Negation>(operand2)),
                     lb, ub);
-                acc = calc_accuracy(*candidate, traces_pos_train,
-                                    traces_neg_train);
-#pragma omp critical
-                {
-                  keep_best(candidates_best, candidates_worst,
-                            std::move(candidate), acc, depth, max_formulas);
-                }
+                top.offer(std::move(candidate), depth);
               }
             }
           }
@@ -832,15 +920,16 @@ int main(int argc, char *argv[]) {
     */
     // END USING WORST
 
-    formulas_best.merge(candidates_best);
-    formulas_worst.merge(candidates_worst);
-    // cut fat, now get rid of the worst 50% of formulas to avoid growing the
-    // state space
-    while (formulas_best.size() > max_formulas) {
-      formulas_best.erase(formulas_best.begin());
+    for (TopK &top : tops) {
+      top.merge_into(candidates_best, candidates_worst);
+    }
+    // cut fat, keep the max_formulas best of both depths to avoid growing
+    // the state space, and one formula per signature
+    for (const NodeWrapper &f : candidates_best) {
+      prune_stats.equivalent += formulas_best.keep(f, max_formulas);
     }
-    while (formulas_worst.size() > max_formulas) {
-      formulas_worst.erase(formulas_worst.begin());
+    for (const NodeWrapper &f : candidates_worst) {
+      formulas_worst.keep(f, max_formulas);
     }
   }
 
@@ -935,6 +1024,20 @@ int main(int argc, char *argv[]) {
   cout << "num best formulas: " << formulas_best.size() << "\n";
   cout << "num worst formulas: " << formulas_worst.size() << "\n";
   cout << "num_perfect: " << num_perfect << "\n";
+  cout << "candidates scored: " << prune_stats.offered << "\n";
+  cout << "  rejected below the top-k thresholds: "
+       << prune_stats.below_threshold << "\n";
+  cout << "  of those abandoned before the last train trace: "
+       << prune_stats.abandoned << "\n";
+  cout << "  pruned as equivalent on the train traces: "
+       << prune_stats.equivalent << "\n";
+  cout << "train traces scored: " << prune_stats.traces_scored << " of "
+       << prune_stats.offered * train.num_traces() << "\n";
+  cout << "remembered signatures: " << train.num_remembered() << "\n";
+  cout << "simplified nodes: " << simplify_stats.nodes_before << " -> "
+       << simplify_stats.nodes_after << "\n";
+  cout << "simplified cost: " << simplify_stats.cost_before << " -> "
+       << simplify_stats.cost_after << "\n";
   cout << "total time taken: " << time_taken << "s\n";
 
   return 0;
@@ -0,0 +1,423 @@
+#include "signature.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "packed_trace.h"
+
+using namespace std;
+using namespace libmltl;
+
+// splitmix64 finalizer
+static uint64_t mix(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111eb;
+  return x ^ (x >> 31);
+}
+
+Fingerprint fingerprint(const Signature &s) {
+  // two independently seeded chains over the words
+  Fingerprint fp{0x9e3779b97f4a7c15, 0xc2b2ae3d27d4eb4f};
+  for (uint64_t w : s) {
+    fp.lo = mix(fp.lo ^ w);
+    fp.hi = mix(fp.hi + ((w << 32) | (w >> 32)) + 0x165667b19e3779f9);
+  }
+  return fp;
+}
+
+SignatureScorer::SignatureScorer(const vector<vector<string>> &pos,
+                                 const vector<vector<string>> &neg)
+    : pos(pos), neg(neg) {
+  size_t width = 0;
+  for (const vector<vector<string>> *traces : {&pos, &neg}) {
+    for (const vector<string> &trace : *traces) {
+      offsets.push_back(words);
+      lengths.push_back(trace.size());
+      words += max<size_t>(1, (trace.size() + 63) / 64);
+      max_row_words = max(max_row_words, words - offsets.back());
+      for (const string &state : trace) {
+        width = max(width, state.length());
+      }
+    }
+  }
+  valid.assign(words, 0);
+  none.assign(words, 0);
+  for (size_t i = 0; i < lengths.size(); ++i) {
+    set_range(valid.data() + offsets[i], 0, lengths[i], true);
+  }
+
+  vector<Signature> columns(width, Signature(words, 0));
+  size_t i = 0;
+  for (const vector<vector<string>> *traces : {&pos, &neg}) {
+    for (const vector<string> &trace : *traces) {
+      for (size_t t = 0; t < trace.size(); ++t) {
+        for (size_t v = 0; v < trace[t].length(); ++v) {
+          if (trace[t][v] == '1') {
+            set_bit(columns[v].data() + offsets[i], t, true);
+          }
+        }
+      }
+      ++i;
+    }
+  }
+  for (Signature &column : columns) {
+    variables.push_back(make_shared<const Signature>(std::move(column)));
+  }
+  for (size_t i = 0; i < lengths.size(); ++i) {
+    order.push_back(i);
+  }
+}
+
+static bool bit(const uint64_t *v, size_t i) {
+  return (v[i / 64] >> (i % 64)) & 1;
+}
+
+// o = valid & ~a on n words
+static void negate_row(const uint64_t *a, const uint64_t *valid, uint64_t *o,
+                   size_t n) {
+  for (size_t w = 0; w < n; ++w) {
+    o[w] = valid[w] & ~a[w];
+  }
+}
+
+// x[t] = OR of x[t .. t+w-1] on one row of n words, doubling the covered
+// window each pass, scratch holds n words
+static void window_or(uint64_t *x, uint64_t *scratch, size_t n, size_t w) {
+  w = min(w, n * 64); // wider windows only add padding bits
+  if (n == 1) {
+    // the common case of traces up to 64 steps, kept free of calls
+    for (size_t len = 1; len < w;) {
+      size_t step = min(len, w - len);
+      x[0] |= x[0] >> step;
+      len += step;
+    }
+    return;
+  }
+  for (size_t len = 1; len < w;) {
+    size_t step = min(len, w - len);
+    bits_shift_down(x, scratch, n, step, false);
+    bits_or(x, scratch, x, n);
+    len += step;
+  }
+}
+
+// o[t] = OR of a[t+lb .. t+ub], positions past the end of the row are
+// false, so a window starting past the end is false
+static void finally(const uint64_t *a, uint64_t *o, size_t n, size_t lb,
+                    size_t ub, uint64_t *scratch) {
+  if (n == 1) {
+    o[0] = lb < 64 ? a[0] >> lb : 0;
+  } else {
+    bits_shift_down(a, o, n, lb, false);
+  }
+  window_or(o, scratch, n, ub - lb + 1);
+}
+
+// o[t] = some s in [t+lb, min(t+ub, len-1)] has r[s] and l on [t+lb, s),
+// o starts out zero
+static void until(const uint64_t *l, const uint64_t *r, uint64_t *o,
+                  size_t n, size_t len, size_t lb, size_t ub,
+                  vector<size_t> &next_r, vector<size_t> &next_not_l) {
+  if (n == 1) {
+    // one shift per offset in the window, r is zero past the end
+    uint64_t l_so_far = ~uint64_t(0);
+    for (size_t k = lb; k <= ub && k < len && l_so_far; ++k) {
+      o[0] |= l_so_far & (r[0] >> k);
+      l_so_far &= l[0] >> k;
+    }
+    return;
+  }
+  // first position >= s where r holds, where l fails, len if none
+  next_r.assign(len + 1, len);
+  next_not_l.assign(len + 1, len);
+  for (size_t s = len; s-- > 0;) {
+    next_r[s] = bit(r, s) ? s : next_r[s + 1];
+    next_not_l[s] = bit(l, s) ? next_not_l[s + 1] : s;
+  }
+  for (size_t t = 0; t + lb < len; ++t) {
+    const size_t s = next_r[t + lb];
+    if (s <= min(t + ub, len - 1) && next_not_l[t + lb] >= s) {
+      o[t / 64] |= uint64_t(1) << (t % 64);
+    }
+  }
+}
+
+// buffers of one row for the kernels
+struct SignatureScorer::Scratch {
+  Signature a, b, c;
+  vector<size_t> next_r, next_not_l;
+  vector<shared_ptr<Signature>> nodes; // see compute()
+  Scratch() = default;
+  explicit Scratch(size_t n) : a(n), b(n), c(n) {}
+  // score() reuses one per thread, the node buffers are dropped when it
+  // moves to a scorer whose signatures have another size
+  void fit(size_t row_words, size_t words) {
+    if (a.size() < row_words) {
+      a.resize(row_words);
+      b.resize(row_words);
+      c.resize(row_words);
+    }
+    if (!nodes.empty() && nodes[0]->size() != words) {
+      nodes.clear();
+    }
+  }
+};
+
+void SignatureScorer::compute_rows(const ASTNode &f, const Signature *left,
+                                   const Signature *right, Signature &out,
+                                   const size_t *rows, size_t count,
+                                   Scratch &scratch) const {
+  const ASTNode::Type type = f.get_type();
+  size_t lb = 0, ub = 0;
+  if (type == ASTNode::Type::Finally) {
+    lb = static_cast<const Finally &>(f).get_lb();
+    ub = static_cast<const Finally &>(f).get_ub();
+  } else if (type == ASTNode::Type::Globally) {
+    lb = static_cast<const Globally &>(f).get_lb();
+    ub = static_cast<const Globally &>(f).get_ub();
+  } else if (type == ASTNode::Type::Until) {
+    lb = static_cast<const Until &>(f).get_lb();
+    ub = static_cast<const Until &>(f).get_ub();
+  } else if (type == ASTNode::Type::Release) {
+    lb = static_cast<const Release &>(f).get_lb();
+    ub = static_cast<const Release &>(f).get_ub();
+  }
+  uint64_t *sa = scratch.a.data(), *sb = scratch.b.data(),
+           *sc = scratch.c.data();
+
+  for (size_t k = 0; k < count; ++k) {
+    const size_t i = rows[k];
+    const size_t n = row_words(i), len = lengths[i];
+    const uint64_t *v = valid.data() + offsets[i];
+    const uint64_t *a = left->data() + offsets[i];
+    const uint64_t *b = right ? right->data() + offsets[i] : nullptr;
+    uint64_t *o = out.data() + offsets[i];
+    switch (type) {
+    case ASTNode::Type::Negation:
+      negate_row(a, v, o, n);
+      break;
+    case ASTNode::Type::Finally:
+      finally(a, o, n, lb, ub, sc);
+      break;
+    case ASTNode::Type::Globally:
+      // G[a,b] x = !F[a,b] !x
+      negate_row(a, v, sa, n);
+      finally(sa, o, n, lb, ub, sc);
+      negate_row(o, v, o, n);
+      break;
+    case ASTNode::Type::Until:
+      fill(o, o + n, 0);
+      until(a, b, o, n, len, lb, ub, scratch.next_r, scratch.next_not_l);
+      break;
+    case ASTNode::Type::Release:
+      // x R[a,b] y = !(!x U[a,b] !y)
+      negate_row(a, v, sa, n);
+      negate_row(b, v, sb, n);
+      fill(o, o + n, 0);
+      until(sa, sb, o, n, len, lb, ub, scratch.next_r, scratch.next_not_l);
+      negate_row(o, v, o, n);
+      break;
+    case ASTNode::Type::And:
+      for (size_t w = 0; w < n; ++w) {
+        o[w] = a[w] & b[w];
+      }
+      break;
+    case ASTNode::Type::Or:
+      for (size_t w = 0; w < n; ++w) {
+        o[w] = a[w] | b[w];
+      }
+      break;
+    case ASTNode::Type::Implies:
+      for (size_t w = 0; w < n; ++w) {
+        o[w] = (v[w] & ~a[w]) | b[w];
+      }
+      break;
+    case ASTNode::Type::Xor:
+      for (size_t w = 0; w < n; ++w) {
+        o[w] = a[w] ^ b[w];
+      }
+      break;
+    case ASTNode::Type::Equiv:
+      for (size_t w = 0; w < n; ++w) {
+        o[w] = v[w] & ~(a[w] ^ b[w]);
+      }
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+// a signature f does not need computed: remembered, constant or variable,
+// null otherwise
+const Signature *SignatureScorer::known(const ASTNode &f) const {
+  auto it = remembered.find(&f);
+  if (it != remembered.end()) {
+    return it->second.second.get();
+  }
+  if (f.get_type() == ASTNode::Type::Constant) {
+    return static_cast<const Constant &>(f).get_value() ? &valid : &none;
+  }
+  if (f.get_type() == ASTNode::Type::Variable) {
+    unsigned id = static_cast<const Variable &>(f).get_id();
+    // past the width of every trace, never true
+    return id < variables.size() ? variables[id].get() : &none;
+  }
+  return nullptr;
+}
+
+/* Computes rows rows[0 .. count) of f and of its operands that are not
+ * known into scratch.nodes, one buffer per node in pre-order starting at
+ * next, so every block of rows of the same f reuses the same buffers.
+ */
+const Signature *SignatureScorer::compute(const ASTNode &f,
+                                          const size_t *rows, size_t count,
+                                          Scratch &scratch,
+                                          size_t &next) const {
+  if (const Signature *s = known(f)) {
+    return s;
+  }
+  if (next == scratch.nodes.size()) {
+    scratch.nodes.push_back(make_shared<Signature>(words, 0));
+  }
+  Signature *out = scratch.nodes[next++].get();
+  const Signature *left, *right = nullptr;
+  if (f.is_unary_op()) {
+    const ASTNode &operand = static_cast<const UnaryOp &>(f).get_operand();
+    left = compute(operand, rows, count, scratch, next);
+  } else {
+    const BinaryOp &op = static_cast<const BinaryOp &>(f);
+    left = compute(op.get_left(), rows, count, scratch, next);
+    right = compute(op.get_right(), rows, count, scratch, next);
+  }
+  compute_rows(f, left, right, *out, rows, count, scratch);
+  return out;
+}
+
+shared_ptr<const Signature>
+SignatureScorer::lookup(const ASTNode &f) const {
+  auto it = remembered.find(&f);
+  if (it != remembered.end()) {
+    return it->second.second;
+  }
+  if (const Signature *s = known(f)) {
+    return make_shared<const Signature>(*s);
+  }
+  Scratch scratch(max_row_words);
+  size_t next = 0;
+  compute(f, order.data(), order.size(), scratch, next);
+  return scratch.nodes[0];
+}
+
+void SignatureScorer::check(const ASTNode &f, const Signature &s) const {
+#ifdef DEBUG
+  // the kernels must agree with libmltl on every trace
+  for (size_t i = 0; i < lengths.size(); ++i) {
+    const vector<string> &trace =
+        i < pos.size() ? pos[i] : neg[i - pos.size()];
+    if (get_bit(s.data() + offsets[i], 0) != f.evaluate(trace)) {
+      cerr << "signature of " << f.as_pretty_string()
+           << " disagrees with evaluate on train trace " << i << "\n";
+      abort();
+    }
+  }
+#endif
+}
+
+shared_ptr<const Signature>
+SignatureScorer::signature(const ASTNode &f) const {
+  shared_ptr<const Signature> s = lookup(f);
+  check(f, *s);
+  return s;
+}
+
+Score SignatureScorer::score(const ASTNode &f, float best,
+                             float worst) const {
+  Score result;
+  const size_t total = lengths.size();
+  if (known(f)) {
+    result.signature = signature(f);
+    result.accuracy = accuracy(*result.signature);
+    result.traces = total;
+    return result;
+  }
+
+  // the whole formula a block of rows at a time, in order, so that an
+  // abandoned candidate skips the rest of its operands too
+  const size_t block = 16;
+  thread_local Scratch scratch;
+  scratch.fit(max_row_words, words);
+  const Signature *out = nullptr;
+  int traces_satisified = 0;
+  for (size_t k = 0; k < total;) {
+    // every row is a hit or a miss, so it cannot be abandoned before it has
+    // enough of both, a block size that only saves calls if underestimated
+    const double hits = floor(worst * total) + 1 - traces_satisified;
+    const double misses =
+        floor((1 - best) * total) + 1 - (k - traces_satisified);
+    const double ahead = max(hits, 0.0) + max(misses, 0.0);
+    const size_t count = ahead >= total - k
+                             ? total - k
+                             : min(max(block, (size_t)ahead), total - k);
+    size_t next = 0;
+    out = compute(f, order.data() + k, count, scratch, next);
+    for (size_t j = k; j < k + count; ++j) {
+      traces_satisified +=
+          ((*out)[offsets[order[j]]] & 1) == (order[j] < pos.size());
+    }
+    k += count;
+    float optimistic = (traces_satisified + total - k) / (float)total;
+    float pessimistic = traces_satisified / (float)total;
+    if (k < total && optimistic < best && pessimistic > worst) {
+      result.accuracy = pessimistic;
+      result.traces = k;
+      result.abandoned = true;
+      return result;
+    }
+  }
+  check(f, *out);
+  result.accuracy = traces_satisified / (float)total;
+  result.traces = total;
+  // the candidate keeps the root buffer, the next one gets a fresh one
+  result.signature = std::move(scratch.nodes[0]);
+  scratch.nodes[0] = make_shared<Signature>(words, 0);
+  return result;
+}
+
+void SignatureScorer::order_traces(
+    const vector<shared_ptr<libmltl::ASTNode>> &formulas) {
+  // a trace half of the formulas get right tells them apart the most
+  vector<size_t> right(lengths.size(), 0);
+  for (const shared_ptr<ASTNode> &f : formulas) {
+    shared_ptr<const Signature> s = lookup(*f);
+    for (size_t i = 0; i < lengths.size(); ++i) {
+      right[i] += ((*s)[offsets[i]] & 1) == (i < pos.size());
+    }
+  }
+  const size_t k = formulas.size();
+  stable_sort(order.begin(), order.end(), [&](size_t i, size_t j) {
+    return right[i] * (k - right[i]) > right[j] * (k - right[j]);
+  });
+}
+
+float SignatureScorer::accuracy(const Signature &s) const {
+  int traces_satisified = 0;
+  for (size_t i = 0; i < lengths.size(); ++i) {
+    traces_satisified += (s[offsets[i]] & 1) == (i < pos.size());
+  }
+  return traces_satisified / (float)lengths.size();
+}
+
+float SignatureScorer::accuracy(const ASTNode &f) const {
+  return accuracy(*signature(f));
+}
+
+void SignatureScorer::remember(const shared_ptr<ASTNode> &f) {
+  if (remembered.count(f.get()) == 0) {
+    shared_ptr<const Signature> s = lookup(*f);
+    remembered.emplace(f.get(), make_pair(f, std::move(s)));
+  }
+}
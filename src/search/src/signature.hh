@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ast.hh"
+
+/* Truth matrix of a formula over a fixed list of traces, one row per trace:
+ * bit t of row i is the verdict of the formula on the suffix of trace i
+ * starting at t. Each row starts on a word boundary and the bits past the
+ * end of its trace are kept zero.
+ */
+typedef std::vector<uint64_t> Signature;
+
+/* 128-bit hash of a signature. Formulas with the same fingerprint agree at
+ * every position of every trace, so one can stand in for the other in any
+ * formula built on top of them.
+ */
+struct Fingerprint {
+  uint64_t lo = 0;
+  uint64_t hi = 0;
+  bool operator==(const Fingerprint &rhs) const {
+    return lo == rhs.lo && hi == rhs.hi;
+  }
+};
+
+Fingerprint fingerprint(const Signature &s);
+
+/* For unordered containers of fingerprints, the low word is already a hash
+ */
+struct FingerprintHash {
+  size_t operator()(const Fingerprint &f) const { return f.lo; }
+};
+
+/* Accuracy of a candidate scored against the current thresholds
+ */
+struct Score {
+  float accuracy = 0;     // a lower bound if abandoned
+  size_t traces = 0;      // rows of the root computed
+  bool abandoned = false; // stopped once it could not reach either threshold
+  std::shared_ptr<const Signature> signature; // null if abandoned
+};
+
+/* Scores formulas on a fixed set of positive and negative traces without
+ * evaluating their ASTs. The signature of a formula is composed from the
+ * signatures of its operands with bitwise kernels: AND/OR/NOT word by word,
+ * F and G as sliding windows, U and R with one pass per row. Operands whose
+ * signature was remembered are not recomputed, so a candidate built on top
+ * of remembered formulas costs one kernel per new node.
+ *
+ * Follows libmltl's finite trace semantics: on a suffix of length n,
+ * F[a,b] and U[a,b] look at positions a .. min(b, n-1) and are false if
+ * n <= a, G[a,b] and R[a,b] are their duals.
+ */
+class SignatureScorer {
+public:
+  SignatureScorer(const std::vector<std::vector<std::string>> &pos,
+                  const std::vector<std::vector<std::string>> &neg);
+
+  /* Signature of f. Safe to call from several threads as long as no one
+   * calls remember() at the same time. A DEBUG build checks it against
+   * ASTNode::evaluate on every trace.
+   */
+  std::shared_ptr<const Signature> signature(const libmltl::ASTNode &f) const;
+
+  /* Fraction of positive traces f satisfies and negative traces it does not
+   */
+  float accuracy(const libmltl::ASTNode &f) const;
+  float accuracy(const Signature &s) const;
+
+  /* Scores f a few traces at a time, in the order of order_traces(), and
+   * abandons it as soon as it can neither reach best (its accuracy will be
+   * below best) nor worst (it will be above worst). A candidate that can
+   * still tie either is scored in full, its signature may match a kept
+   * formula. Pass best < 0 and worst > 1 to score every trace.
+   */
+  Score score(const libmltl::ASTNode &f, float best, float worst) const;
+
+  /* Orders the traces score() goes through, the ones that split formulas
+   * into right and wrong most evenly first, so that a mediocre candidate
+   * gets both its misses and its hits early. Not thread safe.
+   */
+  void order_traces(
+      const std::vector<std::shared_ptr<libmltl::ASTNode>> &formulas);
+
+  /* Caches the signature of f for the formulas built on top of it.
+   * Not thread safe.
+   */
+  void remember(const std::shared_ptr<libmltl::ASTNode> &f);
+
+  size_t num_traces() const { return lengths.size(); }
+  size_t num_remembered() const { return remembered.size(); }
+
+private:
+  struct Scratch;
+
+  std::shared_ptr<const Signature> lookup(const libmltl::ASTNode &f) const;
+  const Signature *known(const libmltl::ASTNode &f) const;
+  const Signature *compute(const libmltl::ASTNode &f, const size_t *rows,
+                           size_t count, Scratch &scratch,
+                           size_t &next) const;
+  // rows rows[0 .. count) of f's signature from those of its operands
+  void compute_rows(const libmltl::ASTNode &f, const Signature *left,
+                    const Signature *right, Signature &out,
+                    const size_t *rows, size_t count, Scratch &scratch) const;
+  void check(const libmltl::ASTNode &f, const Signature &s) const;
+  size_t row_words(size_t i) const {
+    return (i + 1 < offsets.size() ? offsets[i + 1] : words) - offsets[i];
+  }
+
+  const std::vector<std::vector<std::string>> &pos, &neg;
+  std::vector<size_t> lengths; // timesteps of every trace, positives first
+  std::vector<size_t> offsets; // first word of every row
+  std::vector<size_t> order;   // rows in the order score() computes them
+  size_t words = 0;
+  size_t max_row_words = 0;
+  Signature valid; // ones on every position of every trace
+  Signature none;  // all zeros
+  std::vector<std::shared_ptr<const Signature>> variables;
+  // keyed by node address, the node is held so the address stays unique
+  std::unordered_map<const libmltl::ASTNode *,
+                     std::pair<std::shared_ptr<libmltl::ASTNode>,
+                               std::shared_ptr<const Signature>>>
+      remembered;
+};
@@ -0,0 +1,191 @@
+#include "simplify.hh"
+
+using namespace std;
+using namespace libmltl;
+
+static bool is_constant(const ASTNode &ast, bool value) {
+  return ast.get_type() == ASTNode::Type::Constant &&
+         static_cast<const Constant &>(ast).get_value() == value;
+}
+
+static shared_ptr<ASTNode> make_negation(shared_ptr<ASTNode> operand) {
+  if (operand->get_type() == ASTNode::Type::Negation) {
+    return static_cast<Negation &>(*operand).get_operand().deep_copy();
+  }
+  if (operand->get_type() == ASTNode::Type::Constant) {
+    return make_shared<Constant>(is_constant(*operand, false));
+  }
+  return make_shared<Negation>(std::move(operand));
+}
+
+// F[a,b]true is not constant, it is false within a of the end
+static shared_ptr<ASTNode> make_finally(shared_ptr<ASTNode> operand, size_t lb,
+                                        size_t ub) {
+  if (is_constant(*operand, false)) {
+    return operand;
+  }
+  if (operand->get_type() == ASTNode::Type::Finally) {
+    Finally &inner = static_cast<Finally &>(*operand);
+    return make_finally(inner.get_operand().deep_copy(), lb + inner.get_lb(),
+                        ub + inner.get_ub());
+  }
+  return make_shared<Finally>(std::move(operand), lb, ub);
+}
+
+// G[a,b]G[c,d] = !F[a,b]F[c,d]!x, so it merges like F. Unlike in the
+// interpreter this also holds for c = d, libmltl's G is true on the suffixes
+// too short to reach its window
+static shared_ptr<ASTNode> make_globally(shared_ptr<ASTNode> operand,
+                                         size_t lb, size_t ub) {
+  if (is_constant(*operand, true)) {
+    return operand;
+  }
+  if (operand->get_type() == ASTNode::Type::Globally) {
+    Globally &inner = static_cast<Globally &>(*operand);
+    return make_globally(inner.get_operand().deep_copy(), lb + inner.get_lb(),
+                         ub + inner.get_ub());
+  }
+  return make_shared<Globally>(std::move(operand), lb, ub);
+}
+
+/* Simplifies a binary node whose operands left and right are already
+ * simplified. ast is the original node, for its type and interval.
+ */
+static shared_ptr<ASTNode> make_binary(const ASTNode &ast,
+                                       shared_ptr<ASTNode> left,
+                                       shared_ptr<ASTNode> right) {
+  switch (ast.get_type()) {
+  case ASTNode::Type::And:
+    if (is_constant(*left, false) || is_constant(*right, true) ||
+        *left == *right) {
+      return left;
+    }
+    if (is_constant(*right, false) || is_constant(*left, true)) {
+      return right;
+    }
+    return make_shared<And>(left, right);
+
+  case ASTNode::Type::Or:
+    if (is_constant(*left, true) || is_constant(*right, false) ||
+        *left == *right) {
+      return left;
+    }
+    if (is_constant(*right, true) || is_constant(*left, false)) {
+      return right;
+    }
+    return make_shared<Or>(left, right);
+
+  case ASTNode::Type::Implies:
+    if (is_constant(*left, false) || is_constant(*right, true) ||
+        *left == *right) {
+      return make_shared<Constant>(true);
+    }
+    if (is_constant(*left, true)) {
+      return right;
+    }
+    if (is_constant(*right, false)) {
+      return make_negation(left);
+    }
+    return make_shared<Implies>(left, right);
+
+  // the first right operand in the window has to be at a unless the left
+  // one is true
+  case ASTNode::Type::Until: {
+    const Until &U = static_cast<const Until &>(ast);
+    if (is_constant(*right, false)) {
+      return right;
+    }
+    if (is_constant(*left, true)) {
+      return make_finally(right, U.get_lb(), U.get_ub());
+    }
+    if (is_constant(*left, false) || is_constant(*right, true) ||
+        *left == *right) {
+      return make_finally(right, U.get_lb(), U.get_lb());
+    }
+    return make_shared<Until>(left, right, U.get_lb(), U.get_ub());
+  }
+
+  // the first violation of the right operand has to be past a unless the
+  // left one is false
+  case ASTNode::Type::Release: {
+    const Release &R = static_cast<const Release &>(ast);
+    if (is_constant(*right, true)) {
+      return right;
+    }
+    if (is_constant(*left, true) || is_constant(*right, false) ||
+        *left == *right) {
+      return make_globally(right, R.get_lb(), R.get_lb());
+    }
+    return make_shared<Release>(left, right, R.get_lb(), R.get_ub());
+  }
+
+  default:
+    return ast.deep_copy();
+  }
+}
+
+shared_ptr<ASTNode> simplify(const ASTNode &ast) {
+  switch (ast.get_type()) {
+  case ASTNode::Type::Negation:
+    return make_negation(
+        simplify(static_cast<const Negation &>(ast).get_operand()));
+  case ASTNode::Type::Finally: {
+    const Finally &F = static_cast<const Finally &>(ast);
+    return make_finally(simplify(F.get_operand()), F.get_lb(), F.get_ub());
+  }
+  case ASTNode::Type::Globally: {
+    const Globally &G = static_cast<const Globally &>(ast);
+    return make_globally(simplify(G.get_operand()), G.get_lb(), G.get_ub());
+  }
+  case ASTNode::Type::And:
+  case ASTNode::Type::Or:
+  case ASTNode::Type::Implies:
+  case ASTNode::Type::Until:
+  case ASTNode::Type::Release:
+    return make_binary(ast,
+                       simplify(static_cast<const BinaryOp &>(ast).get_left()),
+                       simplify(static_cast<const BinaryOp &>(ast).get_right()));
+  default:
+    // constants, variables, and connectives the rules do not cover
+    return ast.deep_copy();
+  }
+}
+
+static double evaluation_cost(const ASTNode &ast, double weight) {
+  double below = weight;
+  switch (ast.get_type()) {
+  case ASTNode::Type::Finally:
+    below *= static_cast<const Finally &>(ast).get_ub() -
+             static_cast<const Finally &>(ast).get_lb() + 1;
+    break;
+  case ASTNode::Type::Globally:
+    below *= static_cast<const Globally &>(ast).get_ub() -
+             static_cast<const Globally &>(ast).get_lb() + 1;
+    break;
+  case ASTNode::Type::Until:
+    below *= static_cast<const Until &>(ast).get_ub() -
+             static_cast<const Until &>(ast).get_lb() + 1;
+    break;
+  case ASTNode::Type::Release:
+    below *= static_cast<const Release &>(ast).get_ub() -
+             static_cast<const Release &>(ast).get_lb() + 1;
+    break;
+  default:
+    break;
+  }
+  if (ast.is_unary_op()) {
+    return weight +
+           evaluation_cost(static_cast<const UnaryOp &>(ast).get_operand(),
+                           below);
+  }
+  if (ast.is_binary_op()) {
+    return weight +
+           evaluation_cost(static_cast<const BinaryOp &>(ast).get_left(),
+                           below) +
+           evaluation_cost(static_cast<const BinaryOp &>(ast).get_right(),
+                           below);
+  }
+  return weight;
+}
+
+double evaluation_cost(const ASTNode &ast) { return evaluation_cost(ast, 1); }
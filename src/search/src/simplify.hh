@@ -0,0 +1,18 @@
+#pragma once
+
+#include "ast.hh"
+
+/* Simplifies an MLTL formula before it is evaluated, with the same rules as
+ * simplify() in MLTL_interpreter/simplify.h: constant folding, double
+ * negation, merging nested F[a,b]F[c,d] and G[a,b]G[c,d] intervals (also for
+ * c = d, which the interpreter's G semantics rule out),
+ * U and R with constant or repeated operands rewritten to F and G, and
+ * p & p, p | p to p. The result has the same verdict on every trace.
+ */
+std::shared_ptr<libmltl::ASTNode> simplify(const libmltl::ASTNode &ast);
+
+/* Estimated work of evaluating ast per timestep: every node weighs the
+ * product of the window widths (ub - lb + 1) of the temporal operators
+ * above it.
+ */
+double evaluation_cost(const libmltl::ASTNode &ast);
@@ -2,6 +2,8 @@ import os
 import sys
 import tempfile
 import subprocess
+import socket
+import struct
 from pprint import pprint
 import random
 import re
@@ -10,13 +12,133 @@ import mltl_parser
 if sys.platform == 'win32':
     INTERPRET_PATH = os.path.join('MLTL_interpreter', 'bin', 'interpret.exe')
     INTERPRET_BATCH_PATH = os.path.join('MLTL_interpreter', 'bin', 'interpret_batch.exe')
+    INTERPRET_MULTI_PATH = os.path.join('MLTL_interpreter', 'bin', 'interpret_multi.exe')
     WEST_PATH = './west.exe'
 else:
     INTERPRET_PATH = os.path.join('MLTL_interpreter', 'bin', 'interpret')
     INTERPRET_BATCH_PATH = os.path.join('MLTL_interpreter', 'bin', 'interpret_batch')
+    INTERPRET_MULTI_PATH = os.path.join('MLTL_interpreter', 'bin', 'interpret_multi')
     WEST_PATH = './west'
 
 
+class InterpreterClient:
+    '''
+    Client for a long-running "interpret --serve" process, so evaluating a
+    formula costs no process spawn and no temporary files.
+    Input
+        socket_path: UNIX socket of a running server; if None, a server is
+        started as a child process and spoken to over its stdin/stdout
+        flags: extra flags for the started server, e.g. ["-dp"]
+    Formulas are compiled once by the server and cached by their text.
+    '''
+    def __init__(self, socket_path: str=None, flags: list[str]=[]):
+        self.formula_ids = {}
+        self.sock = None
+        self.proc = None
+        if socket_path is not None:
+            self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            self.sock.connect(socket_path)
+        else:
+            self.proc = subprocess.Popen([INTERPRET_PATH, "--serve"] + flags,
+                                         stdin=subprocess.PIPE,
+                                         stdout=subprocess.PIPE)
+
+    def _send(self, data: bytes):
+        if self.sock is not None:
+            self.sock.sendall(data)
+        else:
+            self.proc.stdin.write(data)
+            self.proc.stdin.flush()
+
+    def _recv(self, n: int) -> bytes:
+        data = b""
+        while len(data) < n:
+            chunk = self.sock.recv(n - len(data)) if self.sock is not None else self.proc.stdout.read(n - len(data))
+            if not chunk:
+                raise ConnectionError("interpreter server closed the connection")
+            data += chunk
+        return data
+
+    def _request(self, payload: bytes) -> bytes:
+        self._send(struct.pack("<I", len(payload)) + payload)
+        n = struct.unpack("<I", self._recv(4))[0]
+        response = self._recv(n)
+        if response.startswith(b"error"):
+            raise ValueError(response[6:].decode())
+        return response
+
+    def compile(self, formula: str) -> int:
+        '''
+        Returns the server's id of formula, compiling it on first use
+        '''
+        if formula not in self.formula_ids:
+            response = self._request(b"compile\n" + formula.encode())
+            self.formula_ids[formula] = int(response.split()[1])
+        return self.formula_ids[formula]
+
+    def interpret_batch(self, formula: str, traces: list) -> list[bool]:
+        '''
+        Input
+            formula: a MLTL formula
+            traces: a list of traces, each a list of strings
+        Output
+            the verdict of the formula on each trace, in order
+        '''
+        formula_id = self.compile(formula)
+        body = "\n".join(",".join(trace) for trace in traces)
+        response = self._request(f"eval {formula_id} {len(traces)}\n{body}".encode())
+        bitmap = response[response.index(b"\n") + 1:]
+        return [bool((bitmap[i // 8] >> (i % 8)) & 1) for i in range(len(traces))]
+
+    def interpret(self, formula: str, trace: list[str]) -> bool:
+        return self.interpret_batch(formula, [trace])[0]
+
+    def open_session(self, formula: str) -> int:
+        '''
+        Starts evaluating formula over a trace that grows with append(),
+        returns the session id. Sessions end with the connection.
+        '''
+        formula_id = self.compile(formula)
+        return int(self._request(f"session {formula_id}".encode()).split()[1])
+
+    def append(self, session: int, rows: list[str], verdicts: list[bool]) -> list[bool]:
+        '''
+        Input
+            session: id returned by open_session
+            rows: the timesteps to append, each a string of variable values
+            verdicts: the verdicts returned by the previous append, [] at first
+        Output
+            verdicts updated in place, entry t is the verdict of the formula on
+            the trace from timestep t on. Only the entries the new timesteps
+            can change are sent by the server.
+        '''
+        body = "\n".join(rows)
+        response = self._request(f"append {session} {len(rows)}\n{body}".encode())
+        newline = response.index(b"\n")
+        start, length = (int(x) for x in response[:newline].split()[1:])
+        bitmap = response[newline + 1:]
+        del verdicts[start:]
+        verdicts.extend(bool((bitmap[i // 8] >> (i % 8)) & 1) for i in range(length - start))
+        return verdicts
+
+    def close(self):
+        if self.sock is not None:
+            self.sock.close()
+        else:
+            self.proc.stdin.close()
+            self.proc.wait()
+
+_client = None
+
+def interpreter_client() -> InterpreterClient:
+    '''
+    Shared InterpreterClient, started on first use
+    '''
+    global _client
+    if _client is None:
+        _client = InterpreterClient()
+    return _client
+
 def interpret(formula: str, trace: list[str]) -> bool:
     '''
     Input
@@ -26,22 +148,7 @@ def interpret(formula: str, trace: list[str]) -> bool:
         result: the verdict of the formula on the trace
         i.e. True if the trace satisifes the formula, False otherwise
     '''
-    with tempfile.NamedTemporaryFile(mode='w', delete=False) as f:
-        f.write(formula)
-        formula_path = f.name
-    with tempfile.NamedTemporaryFile(mode='w', delete=False) as f:
-        for line in trace:
-            f.write(",".join(list(line)) + "\n")
-        trace_path = f.name
-    with tempfile.NamedTemporaryFile(delete=False) as outfile:
-        outfile = outfile.name
-    subprocess.run(f"{INTERPRET_PATH} {formula_path} {trace_path} {outfile}", 
-                stdout=subprocess.DEVNULL, 
-                stderr=subprocess.DEVNULL, 
-                shell=True)
-    with open(outfile, 'r') as f:
-        result = f.read()
-    return True if result == "0" else False
+    return interpreter_client().interpret(formula, trace)
 
 def interpret_batch(formula: str, traces) -> dict:
     '''
@@ -72,20 +179,56 @@ def interpret_batch(formula: str, traces) -> dict:
         return results
     
     elif type(traces) == list:
-        # create a temporary directory of traces and call interpret_batch
+        verdicts = interpreter_client().interpret_batch(formula, traces)
+        return {i: verdict for i, verdict in enumerate(verdicts)}
+                        
+    else:
+        print("Invalid traces argument")
+        sys.exit(1)
+
+def interpret_multi(formulas: list[str], traces) -> list[dict]:
+    '''
+    Input
+        formulas: a list of MLTL formulas
+        traces: a directory containing trace files, a trace-set file
+        OR a list of traces
+    Output
+        results: one dictionary per formula, in the same form as interpret_batch
+    Subformulas shared between the formulas are evaluated once per trace,
+    so this is much faster than calling interpret_batch per formula.
+    '''
+    if type(traces) == str and os.path.exists(traces):
+        with tempfile.NamedTemporaryFile(mode='w', delete=False) as f:
+            f.write("\n".join(formulas) + "\n")
+            formula_path = f.name
+        with tempfile.NamedTemporaryFile(delete=False) as outfile:
+            outfile = outfile.name
+        subprocess.run(f"{INTERPRET_MULTI_PATH} {formula_path} {traces} {outfile}", 
+                    stdout=subprocess.DEVNULL, 
+                    stderr=subprocess.DEVNULL, 
+                    shell=True)
+        with open(outfile, 'r') as f:
+            lines = f.read().splitlines()
+        names = lines[0].split(",")
+        results = []
+        for line in lines[1:]:
+            verdicts = line.split(",")
+            results.append({name: verdict == "1" for name, verdict in zip(names, verdicts)})
+        return results
+
+    elif type(traces) == list:
+        # create a temporary directory of traces and call interpret_multi
         with tempfile.TemporaryDirectory() as traces_dir:
-            for i, trace in enumerate(traces):
-                # create a file for each trace with the name as the index
-                with open(os.path.join(traces_dir, f"{i}.txt"), 'w') as f:
-                    for line in trace:
-                        f.write(",".join(list(line)) + "\n")
-            results = interpret_batch(formula, traces_dir)
-            renamed_results = {}
-            for file, verdict in results.items():
-                index = file.replace(str(traces_dir), "").replace(".txt", "").strip()[1:]
-                renamed_results[int(index)] = verdict
+            write_traces_to_dir(traces, traces_dir)
+            results = interpret_multi(formulas, traces_dir)
+            renamed_results = []
+            for result in results:
+                renamed = {}
+                for file, verdict in result.items():
+                    renamed[int(os.path.basename(file).replace(".txt", ""))] = verdict
+                renamed_results.append(renamed)
             return renamed_results
-                        
+
     else:
         print("Invalid traces argument")
         sys.exit(1)
@@ -265,7 +408,7 @@ if __name__ == '__main__':
     print(f"Formula: {formula}")
     print(f"Trace: {trace}")
     print(f"Verdict: {verdict}")
-    # True
+    # False
     print("="*50) 
 
     # SAMPLE USAGE FOR interpret_batch with directory